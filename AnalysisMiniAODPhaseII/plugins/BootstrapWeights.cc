@@ -0,0 +1,53 @@
+#include "BootstrapWeights.h"
+
+#include <cmath>
+
+
+namespace {
+
+  // SplitMix64 finalizer
+  ULong64_t mix(ULong64_t z)
+  {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+  }
+
+  const ULong64_t kGolden = 0x9e3779b97f4a7c15ULL;
+
+  // Weights above are less likely than 1e-10
+  const Int_t kMaxWeight = 13;
+}
+
+
+BootstrapWeights::BootstrapWeights(Int_t nReplicas) :
+  weights(nReplicas, 1)
+{
+  Double_t p = std::exp(-1.);
+  Double_t sum = 0;
+
+  for (Int_t i=0; i<kMaxWeight; i++) {
+    sum += p;
+    cdf.push_back(sum);
+    p /= i + 1;
+  }
+}
+
+
+void BootstrapWeights::generate(UInt_t run, UInt_t lumi, ULong64_t event)
+{
+  const ULong64_t seed = mix(mix(mix(run + kGolden) ^ lumi) ^ event);
+
+  for (size_t k=0; k<weights.size(); k++) {
+
+    // Uniform in [0, 1) with 53 random bits
+    const Double_t u = (mix(seed + (k + 1) * kGolden) >> 11) * (1. / 9007199254740992.);
+
+    Int_t n = 0;
+
+    while (n < kMaxWeight && u >= cdf[n]) n++;
+
+    weights[k] = n;
+  }
+}
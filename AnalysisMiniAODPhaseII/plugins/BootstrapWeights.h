@@ -0,0 +1,32 @@
+#ifndef BootstrapWeights_H
+#define BootstrapWeights_H
+
+#include "Rtypes.h"
+
+#include <vector>
+
+
+//------------------------------------------------------------------------------
+// BootstrapWeights
+//
+// Poisson(1) weights of the current event, one per bootstrap replica. They are
+// a hash of run, lumi, event and the replica index, so an event gets the same
+// weights in every stream, job or shard, and replicas filled by different jobs
+// can be added like the histograms.
+//------------------------------------------------------------------------------
+class BootstrapWeights {
+ public:
+  explicit BootstrapWeights(Int_t nReplicas);
+
+  void generate(UInt_t run, UInt_t lumi, ULong64_t event);
+
+  Int_t size() const { return weights.size(); }
+
+  const Float_t* data() const { return weights.data(); }
+
+ private:
+  std::vector<Float_t>  weights;
+  std::vector<Double_t> cdf;  // P(n <= i) of a Poisson(1)
+};
+
+#endif
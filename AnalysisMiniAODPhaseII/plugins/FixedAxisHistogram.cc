@@ -0,0 +1,152 @@
+#include "FixedAxisHistogram.h"
+
+#include "TH1F.h"
+#include "TH2F.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+
+namespace {
+
+  void checkFixedBins(const TAxis* axis, const char* name)
+  {
+    if (axis->GetXbins()->GetSize() > 0)
+      throw std::invalid_argument(std::string("FixedAxisHistogram: variable bins in ") + name);
+  }
+}
+
+
+FixedAxisHistogram1D::FixedAxisHistogram1D(TH1F* histogram) :
+  histogram(histogram),
+  nbins    (histogram->GetXaxis()->GetNbins()),
+  xmin     (histogram->GetXaxis()->GetXmin()),
+  xmax     (histogram->GetXaxis()->GetXmax()),
+  content  (nbins + 2, 0),
+  sumw2    (nbins + 2, 0),
+  entries  (0),
+  tsumw    (0),
+  tsumw2   (0),
+  tsumwx   (0),
+  tsumwx2  (0),
+  replicas (nullptr),
+  weights  (nullptr),
+  nReplicas(0)
+{
+  checkFixedBins(histogram->GetXaxis(), histogram->GetName());
+}
+
+
+void FixedAxisHistogram1D::bootstrap(TH2F* replicas, const BootstrapWeights* weights)
+{
+  const TAxis* axis = replicas->GetXaxis();
+
+  if (axis->GetNbins() != nbins || axis->GetXmin() != xmin || axis->GetXmax() != xmax ||
+      replicas->GetYaxis()->GetNbins() != weights->size())
+    throw std::invalid_argument(std::string("FixedAxisHistogram: replicas do not match ") + histogram->GetName());
+
+  this->replicas = replicas;
+  this->weights  = weights;
+
+  nReplicas = weights->size();
+
+  replicaContent.assign((nbins + 2) * nReplicas, 0);
+
+  // Only the replica contents are kept
+  if (replicas->GetSumw2N() > 0) replicas->Sumw2(kFALSE);
+}
+
+
+void FixedAxisHistogram1D::flush() const
+{
+  std::copy(content.begin(), content.end(), histogram->GetArray());
+
+  if (histogram->GetSumw2N() > 0)
+    std::copy(sumw2.begin(), sumw2.end(), histogram->GetSumw2()->GetArray());
+
+  Double_t stats[4] = {tsumw, tsumw2, tsumwx, tsumwx2};
+
+  histogram->PutStats(stats);
+  histogram->SetEntries(entries);
+
+  if (nReplicas == 0) return;
+
+  // Replica k is the y bin k+1
+  Float_t* array = replicas->GetArray();
+
+  for (Int_t bin=0; bin<nbins+2; bin++)
+    for (Int_t k=0; k<nReplicas; k++)
+      array[(k + 1) * (nbins + 2) + bin] = replicaContent[bin * nReplicas + k];
+
+  replicas->SetEntries(entries);
+}
+
+
+void FixedAxisHistogram1D::reset()
+{
+  std::fill(content.begin(), content.end(), 0);
+  std::fill(sumw2  .begin(), sumw2  .end(), 0);
+  std::fill(replicaContent.begin(), replicaContent.end(), 0);
+
+  entries = tsumw = tsumw2 = tsumwx = tsumwx2 = 0;
+}
+
+
+std::size_t FixedAxisHistogram1D::bytes() const
+{
+  return sizeof(Float_t) * (content.capacity() + replicaContent.capacity()) + sizeof(Double_t) * sumw2.capacity();
+}
+
+
+FixedAxisHistogram2D::FixedAxisHistogram2D(TH2F* histogram) :
+  histogram(histogram),
+  nbinsx   (histogram->GetXaxis()->GetNbins()),
+  xmin     (histogram->GetXaxis()->GetXmin()),
+  xmax     (histogram->GetXaxis()->GetXmax()),
+  nbinsy   (histogram->GetYaxis()->GetNbins()),
+  ymin     (histogram->GetYaxis()->GetXmin()),
+  ymax     (histogram->GetYaxis()->GetXmax()),
+  content  ((nbinsx + 2) * (nbinsy + 2), 0),
+  sumw2    ((nbinsx + 2) * (nbinsy + 2), 0),
+  entries  (0),
+  tsumw    (0),
+  tsumw2   (0),
+  tsumwx   (0),
+  tsumwx2  (0),
+  tsumwy   (0),
+  tsumwy2  (0),
+  tsumwxy  (0)
+{
+  checkFixedBins(histogram->GetXaxis(), histogram->GetName());
+  checkFixedBins(histogram->GetYaxis(), histogram->GetName());
+}
+
+
+void FixedAxisHistogram2D::flush() const
+{
+  std::copy(content.begin(), content.end(), histogram->GetArray());
+
+  if (histogram->GetSumw2N() > 0)
+    std::copy(sumw2.begin(), sumw2.end(), histogram->GetSumw2()->GetArray());
+
+  Double_t stats[7] = {tsumw, tsumw2, tsumwx, tsumwx2, tsumwy, tsumwy2, tsumwxy};
+
+  histogram->PutStats(stats);
+  histogram->SetEntries(entries);
+}
+
+
+void FixedAxisHistogram2D::reset()
+{
+  std::fill(content.begin(), content.end(), 0);
+  std::fill(sumw2  .begin(), sumw2  .end(), 0);
+
+  entries = tsumw = tsumw2 = tsumwx = tsumwx2 = tsumwy = tsumwy2 = tsumwxy = 0;
+}
+
+
+std::size_t FixedAxisHistogram2D::bytes() const
+{
+  return sizeof(Float_t) * content.capacity() + sizeof(Double_t) * sumw2.capacity();
+}
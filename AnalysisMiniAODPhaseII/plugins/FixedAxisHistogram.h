@@ -0,0 +1,152 @@
+#ifndef FixedAxisHistogram_H
+#define FixedAxisHistogram_H
+
+#include "BootstrapWeights.h"
+
+#include "Rtypes.h"
+
+#include <cstddef>
+#include <vector>
+
+
+class TH1F;
+class TH2F;
+
+
+//------------------------------------------------------------------------------
+// FixedAxisHistogram1D, FixedAxisHistogram2D
+//
+// Inline fill buffers for fixed-bin TH1F / TH2F histograms, with the results
+// of TH1::Fill / TH2::Fill. flush() writes them into the bound histogram.
+//------------------------------------------------------------------------------
+class FixedAxisHistogram1D {
+ public:
+  explicit FixedAxisHistogram1D(TH1F* histogram);
+
+  void Fill(Double_t x)
+  {
+    entries++;
+
+    const Int_t bin = findBin(x);
+
+    content[bin] += 1;
+    sumw2  [bin] += 1;
+
+    if (nReplicas > 0) fillReplicas(bin);
+
+    if (bin == 0 || bin > nbins) return;
+
+    tsumw++;
+    tsumw2++;
+    tsumwx  += x;
+    tsumwx2 += x*x;
+  }
+
+  // Bins replicas like the histogram, one y bin per replica, and fills it with
+  // the weights generated for each event
+  void bootstrap(TH2F* replicas, const BootstrapWeights* weights);
+
+  void flush() const;
+
+  // Back to an empty buffer, the histogram keeps its last flushed content
+  void reset();
+
+  std::size_t bytes() const;
+
+ private:
+  void fillReplicas(Int_t bin)
+  {
+    Float_t*       row = &replicaContent[bin * nReplicas];
+    const Float_t* w   = weights->data();
+
+    for (Int_t k=0; k<nReplicas; k++) row[k] += w[k];
+  }
+
+  Int_t findBin(Double_t x) const
+  {
+    if (x < xmin)    return 0;
+    if (!(x < xmax)) return nbins + 1;  // NaN goes to the overflow, as in TAxis
+
+    return 1 + Int_t(nbins * (x - xmin) / (xmax - xmin));
+  }
+
+  TH1F*                 histogram;
+  Int_t                 nbins;
+  Double_t              xmin;
+  Double_t              xmax;
+  std::vector<Float_t>  content;  // including underflow and overflow
+  std::vector<Double_t> sumw2;
+  Double_t              entries;
+  Double_t              tsumw;
+  Double_t              tsumw2;
+  Double_t              tsumwx;
+  Double_t              tsumwx2;
+  TH2F*                 replicas;
+  const BootstrapWeights* weights;
+  Int_t                 nReplicas;
+  std::vector<Float_t>  replicaContent;  // [bin][replica]
+};
+
+
+class FixedAxisHistogram2D {
+ public:
+  explicit FixedAxisHistogram2D(TH2F* histogram);
+
+  void Fill(Double_t x, Double_t y)
+  {
+    entries++;
+
+    const Int_t binx = findBin(x, nbinsx, xmin, xmax);
+    const Int_t biny = findBin(y, nbinsy, ymin, ymax);
+    const Int_t bin  = biny * (nbinsx + 2) + binx;
+
+    content[bin] += 1;
+    sumw2  [bin] += 1;
+
+    if (binx == 0 || binx > nbinsx) return;
+    if (biny == 0 || biny > nbinsy) return;
+
+    tsumw++;
+    tsumw2++;
+    tsumwx  += x;
+    tsumwx2 += x*x;
+    tsumwy  += y;
+    tsumwy2 += y*y;
+    tsumwxy += x*y;
+  }
+
+  void flush() const;
+
+  void reset();
+
+  std::size_t bytes() const;
+
+ private:
+  static Int_t findBin(Double_t x, Int_t nbins, Double_t min, Double_t max)
+  {
+    if (x < min)    return 0;
+    if (!(x < max)) return nbins + 1;
+
+    return 1 + Int_t(nbins * (x - min) / (max - min));
+  }
+
+  TH2F*                 histogram;
+  Int_t                 nbinsx;
+  Double_t              xmin;
+  Double_t              xmax;
+  Int_t                 nbinsy;
+  Double_t              ymin;
+  Double_t              ymax;
+  std::vector<Float_t>  content;
+  std::vector<Double_t> sumw2;
+  Double_t              entries;
+  Double_t              tsumw;
+  Double_t              tsumw2;
+  Double_t              tsumwx;
+  Double_t              tsumwx2;
+  Double_t              tsumwy;
+  Double_t              tsumwy2;
+  Double_t              tsumwxy;
+};
+
+#endif
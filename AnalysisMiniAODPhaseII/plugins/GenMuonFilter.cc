@@ -0,0 +1,60 @@
+#include "DataFormats/Common/interface/View.h"
+#include "DataFormats/HepMCCandidate/interface/GenParticle.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/Framework/interface/global/EDFilter.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "GenMuonSelection.h"
+
+
+//------------------------------------------------------------------------------
+// GenMuonFilter
+//
+// Keeps the events with at least minMuons gen muons passing the analyzer
+// selection (see GenMuonSelection.h). Used by skimMuons_cfg.py to write the
+// slimmed input of ExampleMuonAnalyzer.
+//------------------------------------------------------------------------------
+class GenMuonFilter : public edm::global::EDFilter<> {
+ public:
+  explicit GenMuonFilter(const edm::ParameterSet& pset);
+
+  bool filter(edm::StreamID, edm::Event& event, const edm::EventSetup&) const override;
+
+ private:
+  edm::EDGetTokenT<edm::View<reco::GenParticle>> prunedGenToken;
+
+  const double   maxEta;
+  const Float_t  minPt;
+  const unsigned minMuons;
+};
+
+
+GenMuonFilter::GenMuonFilter(const edm::ParameterSet& pset) :
+  prunedGenToken(consumes<edm::View<reco::GenParticle>>(pset.getParameter<edm::InputTag>("pruned"))),
+  maxEta        (pset.getParameter<double>("maxEta")),
+  minPt         (pset.getParameter<double>("minPt")),
+  minMuons      (pset.getParameter<unsigned>("minMuons"))
+{
+}
+
+
+bool GenMuonFilter::filter(edm::StreamID, edm::Event& event, const edm::EventSetup&) const
+{
+  edm::Handle<edm::View<reco::GenParticle>> pruned;
+  event.getByToken(prunedGenToken, pruned);
+
+  unsigned nMuons = 0;
+
+  for (const auto& particle : *pruned) {
+
+    if (!isSelectedGenMuon(particle, maxEta, minPt)) continue;
+
+    if (++nMuons >= minMuons) return true;
+  }
+
+  return false;
+}
+
+
+DEFINE_FWK_MODULE(GenMuonFilter);
@@ -0,0 +1,32 @@
+#ifndef GenMuonSelection_H
+#define GenMuonSelection_H
+
+#include "Rtypes.h"
+
+#include <cmath>
+#include <cstdlib>
+
+
+//------------------------------------------------------------------------------
+// Gen muons used as efficiency denominators: prompt, final state, last copy,
+// inside |eta| < maxEta and above minPt. Shared by ExampleMuonAnalyzer and
+// GenMuonFilter, so that the skim keeps every event the analyzer would use.
+//------------------------------------------------------------------------------
+template <class GenParticle>
+bool isSelectedGenMuon(const GenParticle& particle, double maxEta, Float_t minPt)
+{
+  if (std::abs(particle.pdgId()) != 13) return false;
+  if (!particle.isPromptFinalState())  return false;
+  if (!particle.isLastCopy())          return false;
+
+  // Same float precision as the analyzer histograms
+  Float_t eta = particle.eta();
+  Float_t pt  = particle.pt();
+
+  if (std::fabs(eta) > maxEta) return false;
+  if (pt < minPt)              return false;
+
+  return true;
+}
+
+#endif
@@ -0,0 +1,226 @@
+#include "GenParticleGrid.h"
+#include "MuonMatcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+
+namespace {
+  // Packed kinematics are stored with reduced precision, so the packed copy
+  // of a gen muon is not exactly at the pruned one
+  const float kSelfDeltaR = 0.01f;
+}
+
+
+GenParticleGrid::GenParticleGrid(float coneDeltaR, float maxEta, float minPt) :
+  coneDeltaR(coneDeltaR),
+  maxEta    (maxEta + coneDeltaR),
+  minPt     (minPt)
+{
+  // A single cell when the isolation is disabled
+  nEtaCells = (coneDeltaR > 0) ? std::max(1, int(2 * this->maxEta / coneDeltaR)) : 1;
+  nPhiCells = (coneDeltaR > 0) ? std::max(1, int(MuonMatcher::kTwoPi / coneDeltaR)) : 1;
+
+  etaCellWidth = 2 * this->maxEta / nEtaCells;
+  phiCellWidth = MuonMatcher::kTwoPi / nPhiCells;
+
+  clear();
+}
+
+
+void GenParticleGrid::clear()
+{
+  nParticles = 0;
+  nDeltaR    = 0;
+}
+
+
+// Whether a particle is kept is close to random, so the particle is always
+// written and only counted when kept, without a mispredicted branch each
+void GenParticleGrid::add(float eta, float phi, float pt, int pdgId, int charge)
+{
+  if (nParticles == partEta.size()) {
+    const unsigned n = std::max(64u, 2 * nParticles);
+    partEta  .resize(n);
+    partPhi  .resize(n);
+    partPt   .resize(n);
+    partFlags.resize(n);
+    partCell .resize(n);
+  }
+
+  const bool keep = (pt >= minPt) & (std::fabs(eta) <= maxEta) & !isInvisible(pdgId);
+
+  partEta  [nParticles] = eta;
+  partPhi  [nParticles] = phi;
+  partPt   [nParticles] = pt;
+  partFlags[nParticles] = (charge != 0 ? kCharged : 0) | (std::abs(pdgId) == 13 ? kMuon : 0);
+  partCell [nParticles] = etaCell(eta) * nPhiCells + phiCell(phi);
+
+  nParticles += keep;
+}
+
+
+void GenParticleGrid::build()
+{
+  const int nCells = nEtaCells * nPhiCells;
+
+  // Counting sort of the particles by cell
+  cellStart.assign(nCells + 1, 0);
+
+  const unsigned n = nParticles;
+
+  for (unsigned i=0; i<n; i++) cellStart[partCell[i] + 1]++;
+
+  for (int c=0; c<nCells; c++) cellStart[c + 1] += cellStart[c];
+
+  gridEta  .resize(n);
+  gridPhi  .resize(n);
+  gridPt   .resize(n);
+  gridFlags.resize(n);
+
+  for (unsigned i=0; i<n; i++) {
+
+    const int k = cellStart[partCell[i]]++;
+
+    gridEta  [k] = partEta  [i];
+    gridPhi  [k] = partPhi  [i];
+    gridPt   [k] = partPt   [i];
+    gridFlags[k] = partFlags[i];
+  }
+
+  for (int c=nCells; c>0; c--) cellStart[c] = cellStart[c - 1];
+
+  cellStart[0] = 0;
+}
+
+
+GenIsolation GenParticleGrid::isolation(float eta, float phi)
+{
+  GenIsolation result;
+
+  const float cone2 = coneDeltaR * coneDeltaR;
+
+  const int ie0 = etaCell(eta);
+  const int ip0 = phiCell(phi);
+
+  // Distinct phi columns around the muon, all of them on a narrow grid
+  int columns[3];
+  int nColumns = 0;
+
+  if (nPhiCells < 3) {
+    for (int ip=0; ip<nPhiCells; ip++) columns[nColumns++] = ip;
+  } else {
+    for (int dip=-1; dip<=1; dip++) columns[nColumns++] = (ip0 + dip + nPhiCells) % nPhiCells;
+  }
+
+  // The muon itself, and the two closest particles in case it is the closest
+  int   self      = -1;
+  float self2     = kSelfDeltaR * kSelfDeltaR;
+  int   first     = -1;
+  int   second    = -1;
+  float first2    = std::numeric_limits<float>::max();
+  float second2   = std::numeric_limits<float>::max();
+
+  for (int ie=std::max(0, ie0 - 1); ie<=std::min(nEtaCells - 1, ie0 + 1); ie++) {
+
+    for (int c=0; c<nColumns; c++) {
+
+      const int cell = ie * nPhiCells + columns[c];
+
+      for (int k=cellStart[cell]; k<cellStart[cell + 1]; k++) {
+
+	const float dEta = gridEta[k] - eta;
+	const float dPhi = MuonMatcher::deltaPhi(gridPhi[k], phi);
+	const float dR2  = dPhi*dPhi + dEta*dEta;
+
+	nDeltaR++;
+
+	if (dR2 >= cone2) continue;
+
+	if (gridFlags[k] & kCharged)
+	  result.chargedSumPt += gridPt[k];
+	else
+	  result.neutralSumPt += gridPt[k];
+
+	result.nParticles++;
+
+	if ((gridFlags[k] & kMuon) && dR2 < self2) {
+	  self  = k;
+	  self2 = dR2;
+	}
+
+	if (dR2 < first2) {
+	  second  = first;
+	  second2 = first2;
+	  first   = k;
+	  first2  = dR2;
+	} else if (dR2 < second2) {
+	  second  = k;
+	  second2 = dR2;
+	}
+      }
+    }
+  }
+
+  if (self >= 0) {
+
+    if (gridFlags[self] & kCharged)
+      result.chargedSumPt -= gridPt[self];
+    else
+      result.neutralSumPt -= gridPt[self];
+
+    result.nParticles--;
+
+    if (first == self) {
+      first  = second;
+      first2 = second2;
+    }
+  }
+
+  if (first >= 0) {
+    result.nearestDeltaR = std::sqrt(first2);
+    result.nearestPt     = gridPt[first];
+  }
+
+  return result;
+}
+
+
+std::size_t GenParticleGrid::scratchBytes() const
+{
+  return sizeof(float) * (partEta.capacity() + partPhi.capacity() + partPt.capacity() +
+			  gridEta.capacity() + gridPhi.capacity() + gridPt.capacity())
+    + sizeof(int) * (partCell.capacity() + cellStart.capacity())
+    + partFlags.capacity() + gridFlags.capacity();
+}
+
+
+bool GenParticleGrid::isInvisible(int pdgId)
+{
+  const int id = std::abs(pdgId);
+
+  return id == 12 || id == 14 || id == 16 || id == 1000022 || id == 1000039;
+}
+
+
+// The dropped particles can have any eta, infinite or NaN included, so it is
+// clamped before the conversion to int. A NaN goes to the first row.
+int GenParticleGrid::etaCell(float eta) const
+{
+  eta = (eta > -maxEta) ? eta : -maxEta;
+  eta = (eta <  maxEta) ? eta :  maxEta;
+
+  const int ie = int((eta + maxEta) / etaCellWidth);
+
+  return std::min(std::max(ie, 0), nEtaCells - 1);
+}
+
+
+int GenParticleGrid::phiCell(float phi) const
+{
+  const int ip = int((MuonMatcher::deltaPhi(phi, 0) + MuonMatcher::kPi) / phiCellWidth);
+
+  return std::min(std::max(ip, 0), nPhiCells - 1);
+}
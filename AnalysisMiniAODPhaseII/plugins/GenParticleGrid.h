@@ -0,0 +1,93 @@
+#ifndef GenParticleGrid_H
+#define GenParticleGrid_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+//------------------------------------------------------------------------------
+// GenIsolation
+//
+// Gen-level isolation of a gen muon: scalar pt sums of the visible stable gen
+// particles inside the cone, the muon itself excluded, and the closest of
+// them. nearestDeltaR stays at 999 when the cone is empty.
+//------------------------------------------------------------------------------
+struct GenIsolation {
+  float chargedSumPt  = 0;
+  float neutralSumPt  = 0;  // photons included
+  int   nParticles    = 0;
+  float nearestDeltaR = 999;
+  float nearestPt     = -999;
+
+  float sumPt() const { return chargedSumPt + neutralSumPt; }
+};
+
+
+//------------------------------------------------------------------------------
+// GenParticleGrid
+//
+// Per-event eta-phi grid of the packed gen particles, with cells one cone wide,
+// so that an isolation query only scans the 3 x 3 cells around the muon.
+//------------------------------------------------------------------------------
+class GenParticleGrid {
+ public:
+  GenParticleGrid(float coneDeltaR, float maxEta, float minPt);
+
+  // Forget the particles of the previous event
+  void clear();
+
+  void add(float eta, float phi, float pt, int pdgId, int charge);
+
+  // Bucket the particles, must be called after the last add()
+  void build();
+
+  // Isolation of the gen muon at (eta, phi), whose own packed copy is the
+  // closest muon within dR = 0.01
+  GenIsolation isolation(float eta, float phi);
+
+  unsigned size()           const { return nParticles; }
+  unsigned deltaRComputed() const { return nDeltaR; }
+
+  // Memory held by the buffers, kept between events
+  std::size_t scratchBytes() const;
+
+  // Neutrinos and the usual invisible BSM particles
+  static bool isInvisible(int pdgId);
+
+ private:
+  int etaCell(float eta) const;
+  int phiCell(float phi) const;
+
+  enum {kCharged = 1 << 0, kMuon = 1 << 1};
+
+  float coneDeltaR;
+  float maxEta;  // of the kept particles, muon acceptance plus one cone
+  float minPt;
+
+  // Grid
+  int   nEtaCells;
+  int   nPhiCells;
+  float etaCellWidth;
+  float phiCellWidth;
+
+  // Kept particles in the order they were added, the first nParticles of the
+  // buffers
+  unsigned                  nParticles;
+  std::vector<float>        partEta;
+  std::vector<float>        partPhi;
+  std::vector<float>        partPt;
+  std::vector<std::uint8_t> partFlags;
+  std::vector<int>          partCell;
+
+  // The same, sorted by cell, cellStart[c] to cellStart[c+1]
+  std::vector<int>          cellStart;
+  std::vector<float>        gridEta;
+  std::vector<float>        gridPhi;
+  std::vector<float>        gridPt;
+  std::vector<std::uint8_t> gridFlags;
+
+  unsigned nDeltaR;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "ImpactParameters.h"
+
+#include <cmath>
+#include <limits>
+
+
+namespace {
+  // Added under the square roots
+  const float kMinSquare   = std::numeric_limits<float>::min();
+  const float kMinVariance = 1e-12;  // [cm^2], a 0.01 um error
+
+  // The kernel, a free function so that the restrict qualifiers tell the
+  // compiler that the results do not alias the tracks or each other. There
+  // is no branch: a tiny constant under the square roots keeps them away from
+  // zero, which only matters for the tracks without pt or without any error.
+  void computeImpactParameters(unsigned                    n,
+			       const float* __restrict__   x,
+			       const float* __restrict__   y,
+			       const float* __restrict__   z,
+			       const float* __restrict__   px,
+			       const float* __restrict__   py,
+			       const float* __restrict__   pz,
+			       const float* __restrict__   dxyErr2,
+			       const float* __restrict__   dzErr2,
+			       const VertexPoint&          vertex,
+			       float* __restrict__         dxy,
+			       float* __restrict__         dz,
+			       float* __restrict__         lxy,
+			       float* __restrict__         dxySig,
+			       float* __restrict__         dzSig)
+  {
+    const float xv    = vertex.x;
+    const float yv    = vertex.y;
+    const float zv    = vertex.z;
+    const float covXX = vertex.covXX;
+    const float covXY = vertex.covXY;
+    const float covYY = vertex.covYY;
+    const float covZZ = vertex.covZZ;
+
+    for (unsigned i=0; i<n; i++) {
+
+      const float dx  = x[i] - xv;
+      const float dy  = y[i] - yv;
+      const float pt2 = px[i] * px[i] + py[i] * py[i];
+
+      const float invPt = 1 / std::sqrt(pt2 + kMinSquare);
+
+      // Transverse direction of the track, (0, 0) without pt
+      const float ux = px[i] * invPt;
+      const float uy = py[i] * invPt;
+
+      const float d = -dx * uy + dy * ux;
+      const float l = (z[i] - zv) - (dx * ux + dy * uy) * pz[i] * invPt;
+
+      dxy[i] = d;
+      dz [i] = l;
+      lxy[i] = std::sqrt(dx * dx + dy * dy);
+
+      // Vertex covariance along (-uy, ux), and along z
+      const float dxyVar = dxyErr2[i] + uy * uy * covXX - 2 * ux * uy * covXY + ux * ux * covYY;
+      const float dzVar  = dzErr2 [i] + covZZ;
+
+      dxySig[i] = d / std::sqrt(dxyVar + kMinVariance);
+      dzSig [i] = l / std::sqrt(dzVar  + kMinVariance);
+    }
+  }
+}
+
+
+void ImpactParameters::clear()
+{
+  trackX        .clear();
+  trackY        .clear();
+  trackZ        .clear();
+  trackPx       .clear();
+  trackPy       .clear();
+  trackPz       .clear();
+  trackDxyError2.clear();
+  trackDzError2 .clear();
+}
+
+
+void ImpactParameters::add(float x, float y, float z, float px, float py, float pz, float dxyError, float dzError)
+{
+  trackX        .push_back(x);
+  trackY        .push_back(y);
+  trackZ        .push_back(z);
+  trackPx       .push_back(px);
+  trackPy       .push_back(py);
+  trackPz       .push_back(pz);
+  trackDxyError2.push_back(dxyError * dxyError);
+  trackDzError2 .push_back(dzError  * dzError);
+}
+
+
+void ImpactParameters::compute(const VertexPoint& vertex)
+{
+  const unsigned n = size();
+
+  // resize() only allocates while the event is the largest so far
+  outDxy   .resize(n);
+  outDz    .resize(n);
+  outLxy   .resize(n);
+  outDxySig.resize(n);
+  outDzSig .resize(n);
+
+  computeImpactParameters(n,
+			  trackX.data(), trackY.data(), trackZ.data(),
+			  trackPx.data(), trackPy.data(), trackPz.data(),
+			  trackDxyError2.data(), trackDzError2.data(),
+			  vertex,
+			  outDxy.data(), outDz.data(), outLxy.data(), outDxySig.data(), outDzSig.data());
+}
+
+
+std::size_t ImpactParameters::scratchBytes() const
+{
+  return sizeof(float) * (trackX.capacity() + trackY.capacity() + trackZ.capacity()
+			  + trackPx.capacity() + trackPy.capacity() + trackPz.capacity()
+			  + trackDxyError2.capacity() + trackDzError2.capacity()
+			  + outDxy.capacity() + outDz.capacity() + outLxy.capacity()
+			  + outDxySig.capacity() + outDzSig.capacity());
+}
@@ -0,0 +1,79 @@
+#ifndef ImpactParameters_H
+#define ImpactParameters_H
+
+#include <cstddef>
+#include <vector>
+
+
+//------------------------------------------------------------------------------
+// VertexPoint
+//
+// Position [cm] and covariance [cm^2] of the selected primary vertex, or of
+// the beam spot when there is none.
+//------------------------------------------------------------------------------
+struct VertexPoint {
+  float x;
+  float y;
+  float z;
+  float covXX;
+  float covXY;
+  float covYY;
+  float covZZ;
+};
+
+
+//------------------------------------------------------------------------------
+// ImpactParameters
+//
+// Per-event dxy, dz and Lxy of straight-line tracks with respect to a vertex,
+// as in reco::Track::dxy(point), computed for all the tracks in one loop.
+//------------------------------------------------------------------------------
+class ImpactParameters {
+ public:
+  // Forget the tracks of the previous event
+  void clear();
+
+  // Errors [cm] of the track dxy and dz, 0 for the gen muons
+  void add(float x,
+	   float y,
+	   float z,
+	   float px,
+	   float py,
+	   float pz,
+	   float dxyError = 0,
+	   float dzError  = 0);
+
+  // Impact parameters of all the tracks, must be called after the last add()
+  void compute(const VertexPoint& vertex);
+
+  unsigned size() const { return trackX.size(); }
+
+  float dxy            (unsigned i) const { return outDxy   [i]; }  // [cm], signed
+  float dz             (unsigned i) const { return outDz    [i]; }  // [cm], signed
+  float lxy            (unsigned i) const { return outLxy   [i]; }  // [cm]
+  float dxySignificance(unsigned i) const { return outDxySig[i]; }  // signed
+  float dzSignificance (unsigned i) const { return outDzSig [i]; }
+
+  // Memory held by the buffers, kept between events
+  std::size_t scratchBytes() const;
+
+ private:
+  // Tracks, structure of arrays
+  std::vector<float> trackX;
+  std::vector<float> trackY;
+  std::vector<float> trackZ;
+  std::vector<float> trackPx;
+  std::vector<float> trackPy;
+  std::vector<float> trackPz;
+  std::vector<float> trackDxyError2;
+  std::vector<float> trackDzError2;
+
+  // Results
+  std::vector<float> outDxy;
+  std::vector<float> outDz;
+  std::vector<float> outLxy;
+  std::vector<float> outDxySig;
+  std::vector<float> outDzSig;
+};
+
+#endif
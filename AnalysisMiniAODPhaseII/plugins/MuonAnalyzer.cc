@@ -1,150 +1,493 @@
 #include "MuonAnalyzer.h" 
+#include "GenMuonSelection.h"
+#include "MuonCheckpoint.h"
+#include "MuonFlavours.h"
 
 #include "CommonTools/UtilAlgos/interface/TFileService.h"
 #include "DataFormats/BeamSpot/interface/BeamSpot.h"
 #include "DataFormats/Candidate/interface/Candidate.h"
 #include "DataFormats/HepMCCandidate/interface/GenParticle.h"
 #include "DataFormats/Math/interface/LorentzVector.h"
-#include "DataFormats/PatCandidates/interface/PackedGenParticle.h"
+#include "DataFormats/MuonReco/interface/MuonSelectors.h"
+#include "DataFormats/TrackReco/interface/Track.h"
 #include "FWCore/Framework/interface/ESHandle.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
 #include "FWCore/MessageService/interface/MessageServicePresence.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FWCore/ServiceRegistry/interface/Service.h"
+#include "FWCore/Utilities/interface/Exception.h"
 
 #include "TH1I.h"
 #include "TH1F.h"
 #include "TH2F.h"
+#include "TTree.h"
 #include "TLorentzVector.h"
 #include "TMath.h"
 
+#include <algorithm>
+
 using namespace edm;
 using namespace reco;
 using namespace std;
 
 
-ExampleMuonAnalyzer::ExampleMuonAnalyzer(const ParameterSet& pset)
+MuonAnalyzerGlobalCache::MuonAnalyzerGlobalCache(const ParameterSet& pset) :
+  config               (pset),
+  sweep                (readSweep(pset, config)),
+  start                (std::chrono::steady_clock::now()),
+  moduleLabel          (pset.getParameter<std::string>("@module_label")),
+  checkpointFile       (pset.getParameter<std::string>("checkpointFile")),
+  checkpointEvents     (pset.getParameter<unsigned>("checkpointEvents")),
+  checkpointMinutes    (pset.getParameter<double>("checkpointMinutes")),
+  eventsSinceCheckpoint(0),
+  lastCheckpoint       (start)
+{
+}
+
+
+ExampleMuonAnalyzer::ExampleMuonAnalyzer(const ParameterSet& pset, const MuonAnalyzerGlobalCache* cache) :
+  config (cache->config),
+  matcher(config.maxDeltaR, config.maxEta),
+  genGrid(config.genIsoDeltaR, config.maxEta, config.genIsoMinPt),
+  tagProbe(config.minMass, config.maxMass, config.maxEta),
+  bootstrapWeights(config.nReplicas),
+  sweep  (cache->sweep),
+  maxVr  (config.maxVr),
+  lumiEvents(0)
 {
   beamSpotToken  = consumes<reco::BeamSpot>(pset.getParameter<InputTag>("beamSpot"));
   muonToken      = consumes<pat::MuonCollection>(pset.getParameter<InputTag>("MuonCollection"));
-  packedGenToken = consumes<edm::View<pat::PackedGenParticle>>(pset.getParameter<InputTag>("packed"));
-  prunedGenToken = consumes<edm::View<reco::GenParticle>>(pset.getParameter<InputTag>("pruned"));
   vtxToken       = consumes<reco::VertexCollection>(pset.getParameter<InputTag>("vertices"));
+  nProducts      = 3;
+
+  if (config.genMatching) {
+    prunedGenToken = consumes<edm::View<reco::GenParticle>>(pset.getParameter<InputTag>("pruned"));
+    nProducts++;
+  }
+
+  if (config.genIsoDeltaR > 0) {
+    packedGenToken = consumes<edm::View<pat::PackedGenParticle>>(pset.getParameter<InputTag>("packed"));
+    nProducts++;
+  }
+
+  if (config.tagAndProbe) {
+    pfCandToken = consumes<pat::PackedCandidateCollection>(pset.getParameter<InputTag>("pfCandidates"));
+    nProducts++;
+  }
+
+  writeNtuple = pset.getParameter<bool>("writeNtuple");
+
+  idMask = writeNtuple ? (kIsTight | kIsSoft | kIsMedium) : config.idBit;
+
+  const BootstrapWeights* weights = (config.nReplicas > 0) ? &bootstrapWeights : nullptr;
+
+  h.bookDetached(config, true, weights);
+
+  for (const auto& point : sweep) {
+
+    sweepHistograms.emplace_back(new MuonHistograms());
+    sweepHistograms.back()->bookDetached(point.config, false, weights);
+
+    maxVr = std::max(maxVr, point.config.maxVr);
+
+    idMask |= point.config.idBit;
+
+    unsigned m = 0;
+
+    if (config.flavourEnabled[kTight] && !point.config.sameIdSelection(config)) {
+
+      while (m < idSelections.size() && !idSelections[m]->sameIdSelection(point.config)) m++;
+
+      if (m == idSelections.size()) {
+	idSelections.push_back(&point.config);
+	idMatchers.push_back(MuonMatcher(config.maxDeltaR, config.maxEta));
+      }
+
+      m++;
+    }
+
+    sweepMatcher.push_back(m);
+  }
+
+  idMatches.resize(idMatchers.size());
 }
 
 
 ExampleMuonAnalyzer::~ExampleMuonAnalyzer() {}
 
 
-void ExampleMuonAnalyzer::beginJob()
+std::unique_ptr<MuonAnalyzerGlobalCache> ExampleMuonAnalyzer::initializeGlobalCache(const ParameterSet& pset)
 {
-  cout << "\n [ExampleMuonAnalyzer::beginJob]\n" << endl;
+  cout << "\n [ExampleMuonAnalyzer::initializeGlobalCache]\n" << endl;
 
-  edm::Service<TFileService> fileService;
+  std::unique_ptr<MuonAnalyzerGlobalCache> cache(new MuonAnalyzerGlobalCache(pset));
+
+  const std::string resumeFrom = pset.getParameter<std::string>("resumeFrom");
+
+  if (!resumeFrom.empty()) {
+
+    if (pset.getParameter<bool>("writeNtuple"))
+      throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: resumeFrom cannot be used with writeNtuple, the ntuple is not checkpointed\n";
+
+    resumeCheckpoint(cache.get(), resumeFrom);
+  }
+
+  if (pset.getParameter<bool>("writeNtuple")) {
+
+    edm::Service<TFileService> fileService;
+
+    cache->ntuple.book(fileService->make<TTree>("MuonNtuple", "gen muons and unmatched reco muons"));
+  }
+
+  return cache;
+}
+
+
+void ExampleMuonAnalyzer::endStream()
+{
+  const MuonAnalyzerGlobalCache* cache = globalCache();
+
+  std::lock_guard<std::mutex> guard(cache->mutex);
+
+  if (writeNtuple) {
+    cache->ntuple.fill(ntupleRows);
+    ntupleRows.clear();
+  }
+
+  performance.histogramBytes = h.bytes();
+
+  for (const auto& histograms : sweepHistograms) performance.histogramBytes += histograms->bytes();
+
+  cache->performance.push_back(performance);
+
+  mergeHistograms();
+}
+
+
+void ExampleMuonAnalyzer::beginLuminosityBlock(const LuminosityBlock&, const EventSetup&)
+{
+  lumiEvents = 0;
+}
+
+
+void ExampleMuonAnalyzer::endLuminosityBlock(const LuminosityBlock&, const EventSetup&)
+{
+  const MuonAnalyzerGlobalCache* cache = globalCache();
+
+  if (cache->checkpointFile.empty()) return;
+
+  std::lock_guard<std::mutex> guard(cache->mutex);
+
+  mergeHistograms();
+
+  h.reset();
+
+  for (auto& histograms : sweepHistograms) histograms->reset();
+}
+
+
+void ExampleMuonAnalyzer::endLuminosityBlockSummary(const LuminosityBlock&, const EventSetup&, MuonLumiSummary* summary) const
+{
+  summary->events += lumiEvents;
+}
+
+
+std::shared_ptr<MuonLumiSummary> ExampleMuonAnalyzer::globalBeginLuminosityBlockSummary(const LuminosityBlock&,
+											const EventSetup&,
+											const LuminosityBlockContext*)
+{
+  return std::make_shared<MuonLumiSummary>();
+}
+
+
+// Every stream has added its events of this lumi, and no stream has started
+// the next one, so the merged sets hold exactly the processed lumis
+void ExampleMuonAnalyzer::globalEndLuminosityBlockSummary(const LuminosityBlock&        lumi,
+							  const EventSetup&,
+							  const LuminosityBlockContext* context,
+							  MuonLumiSummary*              summary)
+{
+  const MuonAnalyzerGlobalCache* cache = context->global();
+
+  if (cache->checkpointFile.empty()) return;
+
+  std::lock_guard<std::mutex> guard(cache->mutex);
+
+  cache->processedLumis.push_back(MuonLumi(lumi.run(), lumi.luminosityBlock()));
+
+  cache->eventsSinceCheckpoint += summary->events;
+
+  const auto now = std::chrono::steady_clock::now();
 
-  // TH1 histograms
-  hGenMuons_eta = fileService->make<TH1F>("GenMuons_eta", "gen muons eta", 100, -2.5, 2.5);
-  hGenMuons_phi = fileService->make<TH1F>("GenMuons_phi", "gen muons phi", 100, -3.2, 3.2);
-  hGenMuons_pt  = fileService->make<TH1F>("GenMuons_pt",  "gen muons pt",  100,    0, 100); 
-  hGenMuons_vx  = fileService->make<TH1F>("GenMuons_vx",  "gen muons vx",  150,    0, 750);
-  hGenMuons_vy  = fileService->make<TH1F>("GenMuons_vy",  "gen muons vy",  150,    0, 750);
-  hGenMuons_vz  = fileService->make<TH1F>("GenMuons_vz",  "gen muons vz",  150,    0, 750);
-  hGenMuons_vr  = fileService->make<TH1F>("GenMuons_vr",  "gen muons vr",  750,    0, 750);
-
-  hStaMuons_eta = fileService->make<TH1F>("StaMuons_eta", "sta-gen dR-matched eta",         100, -2.5, 2.5);
-  hStaMuons_phi = fileService->make<TH1F>("StaMuons_phi", "sta muons phi",         100, -3.2, 3.2);
-  hStaMuons_dR  = fileService->make<TH1F>("StaMuons_dR",  "sta-gen dR",            100,    0,   4);
-  hStaMuons_pt  = fileService->make<TH1F>("StaMuons_pt",  "sta-gen dR-matched pt", 100,    0, 100);
-  hStaMuons_vr  = fileService->make<TH1F>("StaMuons_vr",  "sta-gen dR-matched vr", 750,    0, 750);
-
-  hStaMuons_noGen_eta = fileService->make<TH1F>("StaMuons_noGen_eta", "sta-gen NO dR-matched eta",         100, -2.5, 2.5);
-  hStaMuons_noGen_vr  = fileService->make<TH1F>("StaMuons_noGen_vr",  "sta-gen NO dR-matched vr", 750,    0, 750);
-  hStaMuons_noGen_pt  = fileService->make<TH1F>("StaMuons_noGen_pt",  "sta-gen NO dR-matched pt", 100,    0, 100);
-
-  hTrkMuons_eta = fileService->make<TH1F>("TrkMuons_eta", "trk-gen dR-matched eta",         100, -2.5, 2.5);
-  hTrkMuons_phi = fileService->make<TH1F>("TrkMuons_phi", "trk muons phi",         100, -3.2, 3.2);
-  hTrkMuons_dR  = fileService->make<TH1F>("TrkMuons_dR",  "trk-gen dR",            100,    0,   4);
-  hTrkMuons_pt  = fileService->make<TH1F>("TrkMuons_pt",  "trk-gen dR-matched pt", 100,    0, 100);
-  hTrkMuons_vr  = fileService->make<TH1F>("TrkMuons_vr",  "trk-gen dR-matched vr", 750,    0, 750);
-
-  hTrkMuons_noGen_eta = fileService->make<TH1F>("TrkMuons_noGen_eta", "trk-gen NO dR-matched eta",         100, -2.5, 2.5);
-  hTrkMuons_noGen_vr  = fileService->make<TH1F>("TrkMuons_noGen_vr",  "trk-gen NO dR-matched vr", 750,    0, 750);
-  hTrkMuons_noGen_pt  = fileService->make<TH1F>("TrkMuons_noGen_pt",  "trk-gen NO dR-matched pt", 100,    0, 100);
-
-
-  hGlbMuons_eta = fileService->make<TH1F>("GlbMuons_eta", "glb-gen dR-matched eta",         100, -2.5, 2.5);
-  hGlbMuons_phi = fileService->make<TH1F>("GlbMuons_phi", "glb muons phi",         100, -3.2, 3.2);
-  hGlbMuons_dR  = fileService->make<TH1F>("GlbMuons_dR",  "glb-gen dR",            100,    0,   4);
-  hGlbMuons_pt  = fileService->make<TH1F>("GlbMuons_pt",  "glb-gen dR-matched pt", 100,    0, 100);
-  hGlbMuons_vr  = fileService->make<TH1F>("GlbMuons_vr",  "glb-gen dR-matched vr", 750,    0, 750);
-
-  hGlbMuons_noGen_eta = fileService->make<TH1F>("GlbMuons_noGen_eta", "glb-gen NO dR-matched eta",         100, -2.5, 2.5);
-  hGlbMuons_noGen_vr  = fileService->make<TH1F>("GlbMuons_noGen_vr",  "glb-gen NO dR-matched vr", 750,    0, 750);
-  hGlbMuons_noGen_pt  = fileService->make<TH1F>("GlbMuons_noGen_pt",  "glb-gen NO dR-matched pt", 100,    0, 100);
-
-  hTightMuons_eta = fileService->make<TH1F>("TightMuons_eta", "ID-gen dR-matched eta",         100, -2.5, 2.5);
-  hTightMuons_phi = fileService->make<TH1F>("TightMuons_phi", "ID muons phi",         100, -3.2, 3.2);
-  hTightMuons_dR  = fileService->make<TH1F>("TightMuons_dR",  "ID-gen dR",            100,    0,   4);
-  hTightMuons_pt  = fileService->make<TH1F>("TightMuons_pt",  "ID-gen dR-matched pt", 100,    0, 100);
-  hTightMuons_vr  = fileService->make<TH1F>("TightMuons_vr",  "ID-gen dR-matched vr", 750,    0, 750);
-
-  hIDMuons_noGen_eta = fileService->make<TH1F>("IDMuons_noGen_eta", "glb-gen NO dR-matched eta",         100, -2.5, 2.5);
-  hIDMuons_noGen_vr  = fileService->make<TH1F>("IDMuons_noGen_vr",  "glb-gen NO dR-matched vr", 750,    0, 750);
-  hIDMuons_noGen_pt  = fileService->make<TH1F>("IDMuons_noGen_pt",  "glb-gen NO dR-matched pt", 100,    0, 100);
-
-
-
-  for (Int_t i=0; i<nbinspt; i++) {
-    hStaMuons_res[i] = fileService->make<TH1F>(Form("StaMuons_res_%d", i), "#Deltaq/p_{T} / q/p_{T}", 60, -1, 1);
-    hTrkMuons_res[i] = fileService->make<TH1F>(Form("TrkMuons_res_%d", i), "#Deltaq/p_{T} / q/p_{T}", 60, -0.1, 0.1);
-    hGlbMuons_res[i] = fileService->make<TH1F>(Form("GlbMuons_res_%d", i), "#Deltaq/p_{T} / q/p_{T}", 60, -0.1, 0.1);
+  const Double_t minutes = std::chrono::duration<Double_t>(now - cache->lastCheckpoint).count() / 60;
+
+  const bool everyLumi = (cache->checkpointEvents == 0 && cache->checkpointMinutes <= 0);
+
+  if (!everyLumi &&
+      !(cache->checkpointEvents > 0 && cache->eventsSinceCheckpoint >= cache->checkpointEvents) &&
+      !(cache->checkpointMinutes > 0 && minutes >= cache->checkpointMinutes)) return;
+
+  writeCheckpoint(cache);
+
+  cache->eventsSinceCheckpoint = 0;
+  cache->lastCheckpoint        = now;
+}
+
+
+// Called with the cache mutex held
+void ExampleMuonAnalyzer::mergeHistograms()
+{
+  const MuonAnalyzerGlobalCache* cache = globalCache();
+
+  h.flush();
+
+  if (!cache->merged) {
+    cache->merged.reset(new MuonHistograms());
+    cache->merged->bookDetached(config);
   }
 
-  // TH2 histograms
-  hGenStaMuons_eta = fileService->make<TH2F>("GenStaMuons_eta", "sta-gen dR-matched eta", 50, -2.5, 2.5, 50, -2.5, 2.5);
-  hGenTrkMuons_eta = fileService->make<TH2F>("GenTrkMuons_eta", "trk-gen dR-matched eta", 50, -2.5, 2.5, 50, -2.5, 2.5);
-  hGenGlbMuons_eta = fileService->make<TH2F>("GenGlbMuons_eta", "glb-gen dR-matched eta", 50, -2.5, 2.5, 50, -2.5, 2.5);
-
-  hGenStaMuons_phi = fileService->make<TH2F>("GenStaMuons_phi", "sta-gen dR-matched phi", 50, -3.2, 3.2, 50, -3.2, 3.2);
-  hGenTrkMuons_phi = fileService->make<TH2F>("GenTrkMuons_phi", "trk-gen dR-matched phi", 50, -3.2, 3.2, 50, -3.2, 3.2);
-  hGenGlbMuons_phi = fileService->make<TH2F>("GenGlbMuons_phi", "glb-gen dR-matched phi", 50, -3.2, 3.2, 50, -3.2, 3.2);
-
-  // Isolation                                                                                                                     
-  hMuPFChargeIso = fileService->make<TH1F>("MuPFChargeIso","Isolation #Delta(R)=0.4: PFCharge",200,0,1);   
-  hMuPFNeutralIso = fileService->make<TH1F>("MuPFNeutralIso","Isolation #Delta(R)=0.4: PFNeutral",200,0,1);
-  hMuPFPhotonIso = fileService->make<TH1F>("MuPFPhotonIso","Isolation #Delta(R)=0.4: PFPhoton",200,0,1);
-  hMuPFPUIso = fileService->make<TH1F>("MuPFPUIso","Isolation #Delta(R)=0.4: PFPU",200,0,1);
-  hMuPFIso = fileService->make<TH1F>("MuPFIso","Isolation #Delta(R)=0.4: SumPt",200,0,1); 
-  hMuPFIso_R = fileService->make<TH2F>("MuPFIso_R","Isolation #Delta(R)=0.4: SumPt vs R",100,0, 15, 100,0,0.5);  
+  cache->merged->add(h);
+
+  if (cache->mergedSweep.empty()) {
+    for (const auto& point : sweep) {
+      cache->mergedSweep.emplace_back(new MuonHistograms());
+      cache->mergedSweep.back()->bookDetached(point.config, false);
+    }
+  }
+
+  for (size_t p=0; p<sweep.size(); p++) {
+    sweepHistograms[p]->flush();
+    cache->mergedSweep[p]->add(*sweepHistograms[p]);
+  }
 }
 
 
-void ExampleMuonAnalyzer::endJob() {}
+void ExampleMuonAnalyzer::flushNtuple()
+{
+  const MuonAnalyzerGlobalCache* cache = globalCache();
+
+  std::lock_guard<std::mutex> guard(cache->mutex);
+
+  cache->ntuple.fill(ntupleRows);
+
+  ntupleRows.clear();
+}
+
+
+void ExampleMuonAnalyzer::fillGenMuon(MuonHistograms&           histograms,
+				      const MuonAnalyzerConfig& cuts,
+				      const GenMuon&            gen,
+				      const MuonMatch         (&matches)[nMuonFlavours])
+{
+  if (gen.vr > cuts.maxVr) return;
+
+  const MuonMatch& tight = matches[kTight];
+
+
+  // Isolation of the ID-matched reco muon
+  //----------------------------------------------------------------------------
+  if (tight.found() && tight.deltaR < cuts.maxDeltaR) histograms.hMuPFIso_R->Fill(gen.vr, table.iso[tight.muon]);
+
+
+  // Impact parameters of the ID-matched reco muon
+  //----------------------------------------------------------------------------
+  if (tight.found() && tight.deltaR < cuts.maxDeltaR) {
+    histograms.hMuDxySig    ->Fill(fabs(recoImpact.dxySignificance(tight.muon)));
+    histograms.hMuDzSig     ->Fill(fabs(recoImpact.dzSignificance (tight.muon)));
+    histograms.hMuDxy_GenDxy->Fill(fabs(gen.dxy), fabs(recoImpact.dxy(tight.muon)));
+  }
+
+
+  // Fill gen histograms
+  //----------------------------------------------------------------------------
+  histograms.fillGen(gen);
+
+
+  // Gen isolation, and the reco isolation of the ID-matched muon against it
+  //----------------------------------------------------------------------------
+  if (cuts.genIsoDeltaR > 0) {
+
+    const GenIsolation& iso = gen.isolation;
+
+    const Float_t genIso = iso.sumPt() / gen.pt;
+
+    histograms.hGenMuonIso          ->Fill(genIso);
+    histograms.hGenMuonChargeIso    ->Fill(iso.chargedSumPt / gen.pt);
+    histograms.hGenMuonNeutralIso   ->Fill(iso.neutralSumPt / gen.pt);
+    histograms.hGenMuonIso_R        ->Fill(gen.vr, genIso);
+    histograms.hGenMuonNearestDR    ->Fill(iso.nearestDeltaR);
+    histograms.hGenMuonConeParticles->Fill(iso.nParticles);
+
+    if (tight.found() && tight.deltaR < cuts.maxDeltaR) histograms.hMuPFIso_GenIso->Fill(genIso, table.iso[tight.muon]);
+  }
+
+
+  // Fill the histograms of each flavour
+  //----------------------------------------------------------------------------
+  forEachFlavour([&](auto flavour)
+    {
+      typedef decltype(flavour) Flavour;
+
+      histograms.fill<Flavour>(matches[Flavour::flavour], gen, cuts);
+    });
+}
+
+
+void ExampleMuonAnalyzer::fillIsolation(MuonHistograms&           histograms,
+					const MuonAnalyzerConfig& cuts)
+{
+  for (unsigned j=0; j<table.size(); j++) {
+
+    if (!cuts.passesIso(table.chargeIso[j])) continue;
+
+    histograms.hMuPFChargeIso ->Fill(table.chargeIso [j]);
+    histograms.hMuPFNeutralIso->Fill(table.neutralIso[j]);
+    histograms.hMuPFPhotonIso ->Fill(table.photonIso [j]);
+    histograms.hMuPFPUIso     ->Fill(table.puIso     [j]);
+    histograms.hMuPFIso       ->Fill(table.iso       [j]);
+  }
+}
+
+
+void ExampleMuonAnalyzer::globalEndJob(const MuonAnalyzerGlobalCache* cache)
+{
+  cout << "\n [ExampleMuonAnalyzer::globalEndJob]\n" << endl;
+
+  edm::Service<TFileService> fileService;
+
+  TFileDirectory& directory = *fileService;
+
+  TFileDirectory instrumentation = fileService->mkdir("instrumentation");
+
+  writeHistograms(directory, instrumentation, cache);
+
+
+  // Throughput summary, also kept in the output
+  //----------------------------------------------------------------------------
+  const Double_t wallSeconds = std::chrono::duration<Double_t>(std::chrono::steady_clock::now() - cache->start).count();
+
+  printPerformance(cout, cache->performance, wallSeconds);
+
+  fillPerformanceTree(instrumentation.make<TTree>("Performance", "ExampleMuonAnalyzer counters and time per stage [s], one entry per stream"),
+		      cache->performance,
+		      wallSeconds);
+}
 
 
 void ExampleMuonAnalyzer::analyze(const Event& event, const EventSetup& eventSetup)
 {
-  // BeamSpot
-  edm::Handle<reco::BeamSpot> beamSpot;
-  event.getByToken(beamSpotToken, beamSpot);
-  reco::BeamSpot bs;
+  Double_t stageSeconds[nMuonStages] = {0};
+
+  clock.start();
+
+  // Products of the event read so far, the others are skipped
+  unsigned productsRead = 0;
+
+
+  // Gen pre-scan. Pruned particles are the ones containing "important" stuff,
+  // not in data. The selected gen muons within maxVr are kept, with their
+  // production point for the impact parameters. The ntuple keeps every vr,
+  // so that maxVr can be changed later. vr is measured from the origin, so
+  // that the cut stays a gen-level one, made before any reco product is read.
+  //----------------------------------------------------------------------------
+  Handle<edm::View<reco::GenParticle> > pruned;
+
+  if (config.genMatching) {
+    event.getByToken(prunedGenToken, pruned);
+    productsRead++;
+  }
+
+  stageSeconds[kFetchStage] += clock.lap();
+
+  Int_t nGenMuons    = 0;  // selected, whatever their vr
+  Int_t nGenMuonsAny = 0;  // selected, within the largest maxVr
+  Int_t nGenMuonsCut = 0;  // selected, within config.maxVr
+
+  genMuons .clear();
+  genImpact.clear();
+
+  sweepGenMuonsCut.assign(sweep.size(), 0);
+
+  const size_t nPruned = config.genMatching ? pruned->size() : 0;
 
-  if (beamSpot.isValid()) bs = *beamSpot;    
+  for (size_t i=0; i<nPruned; i++) {
+
+    const reco::GenParticle& particle = (*pruned)[i];
+
+    if (!isSelectedGenMuon(particle, config.maxEta, config.minPt())) continue;
+
+    Float_t vx = particle.vx();
+    Float_t vy = particle.vy();
+    Float_t vz = particle.vz();
+
+    Float_t vr = sqrt(vx*vx + vy*vy + vz*vz);
+
+    nGenMuons++;
+
+    if (vr <= config.maxVr) nGenMuonsCut++;
+
+    for (size_t p=0; p<sweep.size(); p++)
+      if (vr <= sweep[p].config.maxVr) sweepGenMuonsCut[p]++;
+
+    if (vr <= maxVr) nGenMuonsAny++;
+    else if (!writeNtuple) continue;
+
+    genMuons .push_back(i);
+    genImpact.add(vx, vy, vz, particle.px(), particle.py(), particle.pz());
+  }
+
+  stageSeconds[kFillStage] += clock.lap();
+
+
+  // Without a gen muon within any maxVr the event cannot fill anything, unless
+  // the reco muons are needed on their own: by tag and probe, and by the
+  // ntuple rows of the reco muons not matched to any gen muon
+  //----------------------------------------------------------------------------
+  if (nGenMuonsAny == 0 && !config.tagAndProbe && !writeNtuple) {
+
+    for (Int_t s=0; s<nMuonStages; s++) {
+      h.hStageTime[s]->Fill(1e6 * stageSeconds[s]);
+      performance.seconds[s] += stageSeconds[s];
+    }
+
+    h.hGenMuonsPerEvent->Fill(nGenMuons);
+
+    performance.events++;
+    performance.skippedEvents++;
+    performance.genMuons        += nGenMuons;
+    performance.productsRead    += productsRead;
+    performance.productsSkipped += nProducts - productsRead;
+    lumiEvents++;
+
+    return;
+  }
+
+
+  // Same weights for an event wherever it is processed
+  if (config.nReplicas > 0)
+    bootstrapWeights.generate(event.id().run(), event.luminosityBlock(), event.id().event());
+
+
+  // Get the muon collection
+  Handle<pat::MuonCollection> muons;
+  event.getByToken(muonToken, muons);
 
 
   // Vertex collection
   edm::Handle<reco::VertexCollection> vertices;
   event.getByToken(vtxToken, vertices);
 
+  productsRead += 2;
+
+  stageSeconds[kFetchStage] += clock.lap();
 
 
   // =================================================================================
   // Look for the Primary Vertex (and use the BeamSpot instead, if you can't find it):
-  reco::Vertex::Point posVtx;
-  reco::Vertex::Error errVtx;
   unsigned int theIndexOfThePrimaryVertex = 999.;
   if (vertices.isValid()){
     for (unsigned int ind=0; ind<vertices->size(); ++ind) {
@@ -155,372 +498,433 @@ void ExampleMuonAnalyzer::analyze(const Event& event, const EventSetup& eventSet
     }
   }
   
+  // The vertex of the collection is used in place, without a copy
+  const reco::Vertex* thePrimaryVertex = nullptr;
+  reco::Vertex        beamSpotVertex;
+
   if (theIndexOfThePrimaryVertex<100) {
-    posVtx = ((*vertices)[theIndexOfThePrimaryVertex]).position();
-    errVtx = ((*vertices)[theIndexOfThePrimaryVertex]).error();
+    thePrimaryVertex = &(*vertices)[theIndexOfThePrimaryVertex];
   }   
   else {
     LogInfo("RecoMuonValidator") << "reco::PrimaryVertex not found, use BeamSpot position instead\n";
-    
-    edm::Handle<reco::BeamSpot> recoBeamSpotHandle;
-    event.getByToken(beamSpotToken,recoBeamSpotHandle);
-    reco::BeamSpot bs = *recoBeamSpotHandle;
-    
-    posVtx = bs.position();
-    errVtx(0,0) = bs.BeamWidthX();
-    errVtx(1,1) = bs.BeamWidthY();
-    errVtx(2,2) = bs.sigmaZ();
+
+    // The BeamSpot is only read when there is no primary vertex
+    edm::Handle<reco::BeamSpot> beamSpot;
+    event.getByToken(beamSpotToken, beamSpot);
+    productsRead++;
+
+    reco::Vertex::Error errVtx;
+    errVtx(0,0) = beamSpot->BeamWidthX();
+    errVtx(1,1) = beamSpot->BeamWidthY();
+    errVtx(2,2) = beamSpot->sigmaZ();
+
+    beamSpotVertex   = reco::Vertex(beamSpot->position(), errVtx);
+    thePrimaryVertex = &beamSpotVertex;
   }
-    
-  const reco::Vertex thePrimaryVertex(posVtx,errVtx);
   
   // ==========================================================
 
+  // The impact parameters of the gen and reco muons are measured from it
+  const VertexPoint pv = {Float_t(thePrimaryVertex->x()),
+			  Float_t(thePrimaryVertex->y()),
+			  Float_t(thePrimaryVertex->z()),
+			  Float_t(thePrimaryVertex->covariance(0,0)),
+			  Float_t(thePrimaryVertex->covariance(0,1)),
+			  Float_t(thePrimaryVertex->covariance(1,1)),
+			  Float_t(thePrimaryVertex->covariance(2,2))};
 
-  // Pruned particles are the ones containing "important" stuff
-  Handle<edm::View<reco::GenParticle> > pruned;
-  event.getByToken(prunedGenToken, pruned);
+  stageSeconds[kVertexStage] += clock.lap();
 
 
-  // Packed particles are all the status 1, so usable to remake jets
-  // The navigation from status 1 to pruned is possible (the other direction should be made by hand)
-  Handle<edm::View<pat::PackedGenParticle> > packed;
-  event.getByToken(packedGenToken, packed);
+  // Evaluate isolation, the ID decisions of idMask and impact parameters once
+  // per reco muon
+  //----------------------------------------------------------------------------
+  table.clear();
+  recoImpact.clear();
 
+  for (pat::MuonCollection::const_iterator muon=muons->begin(); muon!=muons->end(); ++muon) {
 
-  // Get the muon collection
-  Handle<pat::MuonCollection> muons;
-  event.getByToken(muonToken, muons);
+    const reco::MuonPFIsolation& pfIso = muon->pfIsolationR04();
+
+    Float_t iso = (pfIso.sumChargedHadronPt + max(0., pfIso.sumNeutralHadronEt + pfIso.sumPhotonEt - 0.5*pfIso.sumPUPt))/muon->pt();
+
+    std::uint8_t idBits = 0;
+
+    if ((idMask & kIsTight)  && muon::isTightMuon(*muon, *thePrimaryVertex)) idBits |= kIsTight;
+    if ((idMask & kIsSoft)   && muon::isSoftMuon (*muon, *thePrimaryVertex)) idBits |= kIsSoft;
+    if ((idMask & kIsMedium) && muon::isMediumMuon(*muon))                  idBits |= kIsMedium;
+    if (muon->isStandAloneMuon())                                          idBits |= kIsStandAlone;
+    if (muon->isTrackerMuon())                                             idBits |= kIsTracker;
+    if (muon->isGlobalMuon())                                              idBits |= kIsGlobal;
 
+    table.push_back(pfIso.sumChargedHadronPt/muon->pt(),
+		    pfIso.sumNeutralHadronEt/muon->pt(),
+		    pfIso.sumPhotonEt/muon->pt(),
+		    pfIso.sumPUPt/muon->pt(),
+		    iso,
+		    idBits);
 
-  // Loop over pruned particles
+    // Best track, the vertex itself with no momentum when there is none
+    const reco::TrackRef track = muon->muonBestTrack();
+
+    if (track.isNonnull())
+      recoImpact.add(track->vx(), track->vy(), track->vz(), track->px(), track->py(), track->pz(), track->dxyError(), track->dzError());
+    else
+      recoImpact.add(pv.x, pv.y, pv.z, 0, 0, 0);
+  }
+
+  recoImpact.compute(pv);
+  genImpact .compute(pv);
+
+
+  stageSeconds[kTableStage] += clock.lap();
+
+
+  // Extract the reco muon candidates of each flavour
   //----------------------------------------------------------------------------
-  for (size_t i=0; i<pruned->size(); i++) {
+  matcher.clear();
 
-    if (abs((*pruned)[i].pdgId()) != 13)    continue;
-    if (!(*pruned)[i].isPromptFinalState()) continue;
-    if (!(*pruned)[i].isLastCopy())         continue;
+  for (size_t j=0; j<muons->size(); j++) {
 
-    Float_t charge = (*pruned)[i].charge();
-    Float_t eta    = (*pruned)[i].eta();
-    Float_t phi    = (*pruned)[i].phi();
-    Float_t pt     = (*pruned)[i].pt();
-    Float_t vx     = (*pruned)[i].vx();
-    Float_t vy     = (*pruned)[i].vy();
-    Float_t vz     = (*pruned)[i].vz();
+    const pat::Muon& muon = (*muons)[j];
 
-    if (fabs(eta) > 2.4) continue;
-    if (pt < ptbins[0])  continue;
+    forEachFlavour([&](auto flavour)
+      {
+	typedef decltype(flavour) Flavour;
 
-    Float_t vr = sqrt(vx*vx + vy*vy + vz*vz);
+	if (!config.flavourEnabled[Flavour::flavour]) return;
+	if (!Flavour::select(table, j, config))       return;
 
+	const MuonKinematics k = Flavour::track(muon);
 
-    // Loop over reconstructed muons
-    //--------------------------------------------------------------------------
-    Float_t sta_min_deltaR =  999;   
-    Float_t sta_eta        = -999;
-    Float_t sta_phi        = -999;
-    Float_t sta_pt         = -999;
-    Float_t sta_res        = -999;
-    
-    Float_t tight_min_deltaR =  999;   
-    Float_t tight_eta        = -999;
-    Float_t tight_phi        = -999;
-    Float_t tight_pt         = -999;
-    
-    Float_t trk_min_deltaR =  999; 
-    Float_t trk_eta        = -999;
-    Float_t trk_phi        = -999;
-    Float_t trk_pt         = -999;
-    Float_t trk_res        = -999;
-
-    Float_t glb_min_deltaR =  999; 
-    Float_t glb_eta        = -999;
-    Float_t glb_phi        = -999;
-    Float_t glb_pt         = -999;
-    Float_t glb_res        = -999;
-
-
-    for (pat::MuonCollection::const_iterator muon=muons->begin(); muon!=muons->end(); ++muon) {
-
-      Float_t iso =  (muon->pfIsolationR04().sumChargedHadronPt + max(0., muon->pfIsolationR04().sumNeutralHadronEt + muon->pfIsolationR04().sumPhotonEt - 0.5*muon->pfIsolationR04().sumPUPt))/muon->pt();
-
-      float chargeIso = (muon->pfIsolationR04().sumChargedHadronPt)/muon->pt();
-      float neutralIso = (muon->pfIsolationR04().sumNeutralHadronEt)/muon->pt();
-      float photonIso = (muon->pfIsolationR04().sumPhotonEt)/muon->pt();
-      float puIso = (muon->pfIsolationR04().sumPUPt)/muon->pt();
-
-      hMuPFChargeIso->Fill(chargeIso);
-      hMuPFNeutralIso->Fill(neutralIso);
-      hMuPFPhotonIso->Fill(photonIso);
-      hMuPFPUIso->Fill(puIso);
-
-      hMuPFIso->Fill(iso);
-
-      hMuPFIso_R->Fill(vr, iso);
-
-      //if ( chargeIso > 0.15) continue;
-
-      /* 
-      bool passID = false; 
-      float nValidHits =  0;
-      float nValidPixelHits = 0; 
-
-      if (muon->isGlobalMuon()) nValidHits = muon->globalTrack()->hitPattern().numberOfValidMuonHits();
-      float nMatched = muon->numberOfMatchedStations();
-      if (muon->isTrackerMuon()) nValidPixelHits =  muon->innerTrack()->hitPattern().numberOfValidPixelHits();
-
-      if ( nValidHits > 1 && nMatched > 1 && nValidPixelHits > 0) passID = true; 
-      */
-
-      // isTightMuon
-      //------------------------------------------------------------------------
-      if (muon::isTightMuon(*muon, thePrimaryVertex)) {
-      //if ( passID) { 
-      // Test Soft muons:: bool muon::isSoftMuon(const reco::Muon & recoMu, const reco::Vertex & vtx);
-
-      //if ( muon::isSoftMuon(*muon, thePrimaryVertex)) {
-     
-	//if (muon::isMediumMuon(*muon)) {
-	
-	  Float_t muEta    = muon->eta();
-	Float_t muPhi    = muon->phi();
-	Float_t muPt     = muon->pt();
-	Float_t muCharge = muon->charge();
-
-	if (fabs(muEta) > 2.4) continue;
-	if (muPt < ptbins[0])  continue;
- 
-
-	Float_t dPhi = muPhi - phi;
-	Float_t dEta = muEta - eta;
-
-	Float_t dR = sqrt(dPhi*dPhi + dEta*dEta); 
-
-	if (dR < tight_min_deltaR) {
-	  tight_min_deltaR = dR;
-	  tight_eta        = muEta;
-	  tight_phi        = muPhi;
-	  tight_pt         = muPt;
-	}
-      }
+	if (fabs(k.eta) > config.maxEta) return;
+	if (k.pt < config.minPt())       return;
 
+	matcher.add(Flavour::flavour, j, k.eta, k.phi, k.pt, k.charge);
+      });
+  }
 
-      // isStandAloneMuon
-      //------------------------------------------------------------------------
-      if (muon->isStandAloneMuon()) {
-     
-	Float_t muEta    = muon->standAloneMuon()->eta();
-	Float_t muPhi    = muon->standAloneMuon()->phi();
-	Float_t muPt     = muon->standAloneMuon()->pt();
-	Float_t muCharge = muon->standAloneMuon()->charge();
+  matcher.build();
 
-	if (fabs(muEta) > 2.4) continue;
-	if (muPt < ptbins[0])  continue;
- 
+  // ID flavour candidates of the sweep points with another ID selection
+  for (size_t m=0; m<idMatchers.size(); m++) {
 
-	Float_t dPhi = muPhi - phi;
-	Float_t dEta = muEta - eta;
+    idMatchers[m].clear();
 
-	Float_t dR = sqrt(dPhi*dPhi + dEta*dEta); 
+    for (size_t j=0; j<muons->size(); j++) {
 
-	if (dR < sta_min_deltaR) {
-	  sta_min_deltaR = dR;
-	  sta_eta        = muEta;
-	  sta_phi        = muPhi;
-	  sta_pt         = muPt;
-	  sta_res        = ((muCharge/muPt) - (charge/pt)) / (charge/pt);
-	}
-      }
+      if (!TightFlavour::select(table, j, *idSelections[m])) continue;
 
-      
-      // isTrackerMuon
-      //------------------------------------------------------------------------
-      if (muon->isTrackerMuon()) {
-
-	float muEta    = muon->innerTrack()->eta();
-	float muPhi    = muon->innerTrack()->phi();
-	float muPt     = muon->innerTrack()->pt();
-	float muCharge = muon->innerTrack()->charge();
-
-	if (fabs(muEta) > 2.4) continue;
-	if (muPt < ptbins[0])  continue;
-       
-	float dPhi = muPhi - phi;
-	float dEta = muEta - eta;
-
-	float dR = sqrt(dPhi*dPhi + dEta*dEta); 
-	
-	if (dR < trk_min_deltaR) {
-	  trk_min_deltaR = dR;
-	  trk_eta        = muEta;
-	  trk_phi        = muPhi;
-	  trk_pt         = muPt;
-	  trk_res        = ((muCharge/muPt) - (charge/pt)) / (charge/pt);
-	}
-      }
+      const MuonKinematics k = TightFlavour::track((*muons)[j]);
+
+      if (fabs(k.eta) > config.maxEta) continue;
+      if (k.pt < config.minPt())       continue;
+
+      idMatchers[m].add(kTight, j, k.eta, k.phi, k.pt, k.charge);
+    }
+
+    idMatchers[m].build();
+  }
+
+  stageSeconds[kMatchStage] += clock.lap();
+
+
+  // Index the packed gen particles for the gen isolation, read only when
+  // there are gen muons to isolate
+  //----------------------------------------------------------------------------
+  if (config.genIsoDeltaR > 0 && !genMuons.empty()) {
+
+    // Packed particles are all the status 1
+    Handle<edm::View<pat::PackedGenParticle> > packed;
+    event.getByToken(packedGenToken, packed);
+    productsRead++;
+
+    stageSeconds[kFetchStage] += clock.lap();
+
+    genGrid.clear();
+
+    for (const auto& particle : *packed) genGrid.add(particle.eta(), particle.phi(), particle.pt(), particle.pdgId(), particle.charge());
+
+    genGrid.build();
+
+    stageSeconds[kGenIsoStage] += clock.lap();
+  }
+
+
+  // Tag-and-probe pairs, each probe passing the flavours it is matched to
+  //----------------------------------------------------------------------------
+  if (config.tagAndProbe) {
+
+    tagProbe.clear();
+
+    for (size_t j=0; j<muons->size(); j++) {
+
+      const pat::Muon& muon = (*muons)[j];
+
+      if (!TightFlavour::select(table, j, config) || table.iso[j] > config.tagMaxIso) continue;
+      if (muon.pt() < config.tagMinPt || fabs(muon.eta()) > config.maxEta)            continue;
+
+      tagProbe.addTag(j, muon.eta(), muon.phi(), muon.pt(), muon.charge());
+    }
+
+    // The probes, the charged packed PF candidates, are only read in the
+    // events with a tag
+    Handle<pat::PackedCandidateCollection> pfCandidates;
 
+    if (tagProbe.nTags() > 0) {
 
-      // isGlobalMuon && isStandAloneMuon
-      //------------------------------------------------------------------------
-      if (muon->isGlobalMuon() && muon->isStandAloneMuon()) {
-
-	float muEta    = muon->globalTrack()->eta();
-	float muPhi    = muon->globalTrack()->phi();
-	float muPt     = muon->globalTrack()->pt();
-	float muCharge = muon->globalTrack()->charge();
-
-	if (fabs(muEta) > 2.4) continue;
-	if (muPt < ptbins[0])  continue;
-       
-	float dPhi = muPhi - phi;
-	float dEta = muEta - eta;
-
-	float dR = sqrt(dPhi*dPhi + dEta*dEta); 
-	
-	if (dR < glb_min_deltaR) {
-	  glb_min_deltaR = dR;
-	  glb_eta        = muEta;
-	  glb_phi        = muPhi;
-	  glb_pt         = muPt;
-	  glb_res        = ((muCharge/muPt) - (charge/pt)) / (charge/pt);
-	}
+      event.getByToken(pfCandToken, pfCandidates);
+      productsRead++;
+
+      for (size_t k=0; k<pfCandidates->size(); k++) {
+
+	const pat::PackedCandidate& candidate = (*pfCandidates)[k];
+
+	if (candidate.charge() == 0)               continue;
+	if (candidate.pt() < config.minPt())       continue;
+	if (fabs(candidate.eta()) > config.maxEta) continue;
+
+	tagProbe.addProbe(k, candidate.eta(), candidate.phi(), candidate.pt(), candidate.charge());
       }
-    }  // for..muons
+    }
 
+    tagProbe.build();
 
-  if (vr > max_vr) continue;
-  
+    for (unsigned i=0; i<tagProbe.nPairs(); i++) {
 
-    // Fill gen histograms
-    //--------------------------------------------------------------------------
-    hGenMuons_eta->Fill(eta);
-    hGenMuons_phi->Fill(phi);
-    hGenMuons_pt ->Fill(pt);
-    hGenMuons_vx ->Fill(fabs(vx));
-    hGenMuons_vy ->Fill(fabs(vy));
-    hGenMuons_vz ->Fill(fabs(vz));
-    hGenMuons_vr ->Fill(vr);
+      const TagProbePair&         pair  = tagProbe.pair(i);
+      const pat::PackedCandidate& probe = (*pfCandidates)[pair.probe];
+
+      MuonMatch matches[nMuonFlavours];
+
+      matcher.match(probe.eta(), probe.phi(), matches);
 
+      forEachFlavour([&](auto flavour)
+	{
+	  typedef decltype(flavour) Flavour;
 
+	  if (config.flavourEnabled[Flavour::flavour])
+	    h.fillTagProbe<Flavour>(matches[Flavour::flavour], pair.mass, probe.pt(), probe.eta(), fabs(probe.dxy()), config);
+	});
+
+      h.hTagProbeMass->Fill(pair.mass);
+    }
 
-    // Fill sta histograms
+    h.hTagProbePairs ->Fill(tagProbe.nPairs());
+    h.hProbesPerEvent->Fill(tagProbe.nProbes());
+
+    stageSeconds[kTnPStage] += clock.lap();
+  }
+
+
+  // Loop over the gen muons of the pre-scan
+  //----------------------------------------------------------------------------
+  if (writeNtuple) matchedMuon.assign(muons->size(), 0);
+
+  for (unsigned g=0; g<genMuons.size(); g++) {
+
+    const reco::GenParticle& particle = (*pruned)[genMuons[g]];
+
+    Float_t charge = particle.charge();
+    Float_t eta    = particle.eta();
+    Float_t phi    = particle.phi();
+    Float_t pt     = particle.pt();
+    Float_t vx     = particle.vx();
+    Float_t vy     = particle.vy();
+    Float_t vz     = particle.vz();
+
+    Float_t vr = sqrt(vx*vx + vy*vy + vz*vz);
+
+
+    // Closest reco muon of each flavour
     //--------------------------------------------------------------------------
-    
-    if (tight_min_deltaR < 999)
-      {
+    MuonMatch matches[nMuonFlavours];
+
+    stageSeconds[kFillStage] += clock.lap();
+
+    matcher.match(eta, phi, matches);
+
+    for (size_t m=0; m<idMatchers.size(); m++) {
+
+      MuonMatch idFlavours[nMuonFlavours];
+
+      idMatchers[m].match(eta, phi, idFlavours);
+
+      idMatches[m] = idFlavours[kTight];
+    }
+
+    stageSeconds[kMatchStage] += clock.lap();
+
+    GenIsolation isolation;
+
+    if (config.genIsoDeltaR > 0) {
+
+      isolation = genGrid.isolation(eta, phi);
+
+      stageSeconds[kGenIsoStage] += clock.lap();
+    }
+
+    if (writeNtuple) {
+
+      MuonNtupleRow row;
+
+      row.reset();
+
+      row.run        = event.id().run();
+      row.lumi       = event.luminosityBlock();
+      row.event      = event.id().event();
+      row.isGen      = true;
+      row.gen_charge = charge;
+      row.gen_pt     = pt;
+      row.gen_eta    = eta;
+      row.gen_phi    = phi;
+      row.gen_vx     = vx;
+      row.gen_vy     = vy;
+      row.gen_vz     = vz;
+      row.gen_vr     = vr;
+      row.gen_dxy    = genImpact.dxy(g);
+      row.gen_dz     = genImpact.dz (g);
+      row.gen_lxy    = genImpact.lxy(g);
 
-	hTightMuons_phi->Fill(tight_phi);
-	hTightMuons_dR ->Fill(tight_min_deltaR);
-	
-	if (tight_min_deltaR < max_deltaR)
-	  {
-	    hTightMuons_eta->Fill(tight_eta);	
-	    hTightMuons_pt->Fill(tight_pt);
-	    hTightMuons_vr->Fill(vr);
-	  } else {
-
-	  hIDMuons_noGen_eta->Fill(tight_eta);	
-	  hIDMuons_noGen_pt->Fill(tight_pt);
-	  hIDMuons_noGen_vr->Fill(vr);
-	}
+      for (Int_t f=0; f<nMuonFlavours; f++) {
+
+	const MuonMatch& m = matches[f];
+
+	if (!m.found()) continue;
+
+	row.dR    [f] = m.deltaR;
+	row.pt    [f] = m.pt;
+	row.eta   [f] = m.eta;
+	row.phi   [f] = m.phi;
+	row.charge[f] = m.charge;
+	row.res   [f] = ((m.charge/m.pt) - (charge/pt)) / (charge/pt);
+	row.id    [f] = table.idBits[m.muon];
+
+	if (m.deltaR < config.maxDeltaR) matchedMuon[m.muon] = 1;
       }
 
-    if (sta_min_deltaR < 999)
-      {
-	//hStaMuons_eta->Fill(sta_eta);
-	hStaMuons_phi->Fill(sta_phi);
-	hStaMuons_dR ->Fill(sta_min_deltaR);
-
-	if (sta_min_deltaR < max_deltaR)
-	  {
-	    hStaMuons_pt->Fill(sta_pt);
-	    hStaMuons_vr->Fill(vr);
-	    hStaMuons_eta->Fill(sta_eta);
-
-	    hGenStaMuons_eta->Fill(eta, sta_eta);
-	    hGenStaMuons_phi->Fill(phi, sta_phi);
-
-	    for (Int_t i=0; i<nbinspt; i++)
-	      if (pt > ptbins[i] && pt < ptbins[i+1]) hStaMuons_res[i]->Fill(sta_res);
-	  } else {
-	  
-	  hStaMuons_noGen_pt->Fill(sta_pt);
-	  hStaMuons_noGen_vr->Fill(vr);
-	  hStaMuons_noGen_eta->Fill(sta_eta);
-	}
+      if (matches[kTight].found()) row.iso = table.iso[matches[kTight].muon];
+
+      if (config.genIsoDeltaR > 0) {
+	row.gen_iso       = isolation.sumPt() / pt;
+	row.gen_chargeIso = isolation.chargedSumPt / pt;
+	row.gen_nearestDR = isolation.nearestDeltaR;
       }
 
+      ntupleRows.push_back(row);
+    }
 
-    // Fill trk histograms
+    // Fill the histograms of the base configuration and of the sweep points
     //--------------------------------------------------------------------------
-    if (trk_min_deltaR < 999)
-      {
+    const GenMuon gen = {charge, eta, phi, pt, vx, vy, vz, vr, genImpact.dxy(g), genImpact.dz(g), genImpact.lxy(g), config.ptBin(pt), isolation};
 
-	hTrkMuons_phi->Fill(trk_phi);
-	hTrkMuons_dR ->Fill(trk_min_deltaR);
+    fillGenMuon(h, config, gen, matches);
 
-	if (trk_min_deltaR < max_deltaR)
-	  {
-	    hTrkMuons_eta->Fill(trk_eta);
-	    hTrkMuons_pt->Fill(trk_pt);
-	    hTrkMuons_vr->Fill(vr);
-	
-	    hGenTrkMuons_eta->Fill(eta, trk_eta);
-	    hGenTrkMuons_phi->Fill(phi, trk_phi);
+    for (size_t p=0; p<sweep.size(); p++) {
 
-	    for (Int_t i=0; i<nbinspt; i++)
-	      if (pt > ptbins[i] && pt < ptbins[i+1]) hTrkMuons_res[i]->Fill(trk_res);
-	  } else {
+      MuonMatch pointMatches[nMuonFlavours];
 
-	  hTrkMuons_noGen_pt->Fill(trk_pt);
-	  hTrkMuons_noGen_vr->Fill(vr);
-	  hTrkMuons_noGen_eta->Fill(trk_eta);
-	}
+      std::copy(matches, matches + nMuonFlavours, pointMatches);
 
-      }
+      if (sweepMatcher[p] > 0) pointMatches[kTight] = idMatches[sweepMatcher[p]-1];
+
+      fillGenMuon(*sweepHistograms[p], sweep[p].config, gen, pointMatches);
+    }
+  } // for..pruned
 
 
-    // Fill glb histograms
-    //--------------------------------------------------------------------------
-    if (glb_min_deltaR < 999)
-      {
-	
-	hGlbMuons_phi->Fill(glb_phi);
-	hGlbMuons_dR ->Fill(glb_min_deltaR);
-
-	if (glb_min_deltaR < max_deltaR)
-	  {
-	    hGlbMuons_eta->Fill(glb_eta);	
-	    hGlbMuons_pt->Fill(glb_pt);
-	    hGlbMuons_vr->Fill(vr);
-
-	    hGenGlbMuons_eta->Fill(eta, glb_eta);
-	    hGenGlbMuons_phi->Fill(phi, glb_phi);
-
-	    for (Int_t i=0; i<nbinspt; i++)
-	      if (pt > ptbins[i] && pt < ptbins[i+1]) hGlbMuons_res[i]->Fill(glb_res);
-	  } else {
-
-	  hGlbMuons_noGen_eta->Fill(glb_eta);	
-	  hGlbMuons_noGen_pt->Fill(glb_pt);
-	  hGlbMuons_noGen_vr->Fill(vr);
-	}
+  // Ntuple rows of the reco muons not matched to any gen muon
+  //----------------------------------------------------------------------------
+  if (writeNtuple) {
+
+    MuonNtupleRow row;
+
+    for (unsigned i=0; i<matcher.size(); i++) {
+
+      const MuonCandidate c = matcher.candidate(i);
+
+      if (matchedMuon[c.muon]) continue;
+
+      // The candidates of a muon are contiguous
+      if (i == 0 || matcher.candidate(i-1).muon != c.muon) {
+	row.reset();
+	row.run   = event.id().run();
+	row.lumi  = event.luminosityBlock();
+	row.event = event.id().event();
+	row.isGen = false;
+	row.iso   = table.iso[c.muon];
       }
 
-    // } else  {
+      row.pt    [c.flavour] = c.pt;
+      row.eta   [c.flavour] = c.eta;
+      row.phi   [c.flavour] = c.phi;
+      row.charge[c.flavour] = c.charge;
+      row.id    [c.flavour] = table.idBits[c.muon];
 
+      if (i+1 == matcher.size() || matcher.candidate(i+1).muon != c.muon) ntupleRows.push_back(row);
+    }
 
+    if (ntupleRows.size() >= ntupleBatchSize) flushNtuple();
+  }
 
-      //    }
 
+  // Fill isolation histograms, once per reco muon in events with gen muons
+  // within the maxVr of each configuration
+  //----------------------------------------------------------------------------
+  if (nGenMuonsCut > 0) fillIsolation(h, config);
 
+  for (size_t p=0; p<sweep.size(); p++)
+    if (sweepGenMuonsCut[p] > 0) fillIsolation(*sweepHistograms[p], sweep[p].config);
 
+  stageSeconds[kFillStage] += clock.lap();
 
-  } // for..pruned
-} 
 
+  // Instrumentation
+  //----------------------------------------------------------------------------
+  for (Int_t s=0; s<nMuonStages; s++) {
+    h.hStageTime[s]->Fill(1e6 * stageSeconds[s]);
+    performance.seconds[s] += stageSeconds[s];
+  }
+
+  h.hGenMuonsPerEvent ->Fill(nGenMuons);
+  h.hRecoMuonsPerEvent->Fill(muons->size());
+  h.hDeltaRPerEvent   ->Fill(matcher.deltaRComputed());
+
+  performance.events++;
+  lumiEvents++;
+  performance.genMuons   += nGenMuons;
+  performance.recoMuons  += muons->size();
+  performance.candidates += matcher.size();
+  performance.deltaR     += matcher.deltaRComputed();
+
+  performance.productsRead    += productsRead;
+  performance.productsSkipped += nProducts - productsRead;
+
+  const std::size_t bytes = scratchBytes();
 
+  if (bytes > performance.peakScratchBytes) {
+    performance.scratchGrowths++;
+    performance.peakScratchBytes = bytes;
+  }
+}
+
+
+std::size_t ExampleMuonAnalyzer::scratchBytes() const
+{
+  std::size_t bytes = table.scratchBytes() + matcher.scratchBytes() + genGrid.scratchBytes() + tagProbe.scratchBytes();
+
+  bytes += genImpact.scratchBytes() + recoImpact.scratchBytes();
+
+  for (const auto& m : idMatchers) bytes += m.scratchBytes();
+
+  bytes += sizeof(MuonMatch)     * idMatches .capacity();
+  bytes += sizeof(MuonNtupleRow) * ntupleRows.capacity();
+  bytes += matchedMuon.capacity();
+  bytes += sizeof(unsigned) * genMuons.capacity();
+  bytes += sizeof(Int_t)    * sweepGenMuonsCut.capacity();
+
+  return bytes;
+}
 
 
 DEFINE_FWK_MODULE(ExampleMuonAnalyzer);
@@ -3,118 +3,196 @@
 
 #include "DataFormats/HepMCCandidate/interface/GenParticle.h"
 #include "DataFormats/PatCandidates/interface/Muon.h"
+#include "DataFormats/PatCandidates/interface/PackedCandidate.h"
 #include "DataFormats/PatCandidates/interface/PackedGenParticle.h"
-#include "FWCore/Framework/interface/EDAnalyzer.h"
+#include "FWCore/Framework/interface/stream/EDAnalyzer.h"
+
+#include "BootstrapWeights.h"
+#include "GenParticleGrid.h"
+#include "ImpactParameters.h"
+#include "MuonAnalyzerConfig.h"
+#include "MuonHistograms.h"
+#include "MuonInstrumentation.h"
+#include "MuonMatcher.h"
+#include "MuonNtuple.h"
+#include "MuonTable.h"
+#include "MuonTagAndProbe.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
 
 namespace edm {
   class ParameterSet;
   class Event;
   class EventSetup;
+  class LuminosityBlock;
 }
 
-class TH1I;
-class TH1F;
-class TH2F;
 
-
-const Int_t   nbinspt = 3;
-
-const Float_t ptbins[nbinspt+1] = {10, 20, 35, 50};
-
-const Float_t max_deltaR = 0.3;
-const Float_t max_vr     =  50;  // [cm]
-
-
-class ExampleMuonAnalyzer: public edm::EDAnalyzer {
+//------------------------------------------------------------------------------
+// Shared by all the streams: the merged histograms, summed in endStream() or at
+// the end of every lumi with a checkpointFile, the ntuple and the counters
+//------------------------------------------------------------------------------
+typedef std::pair<UInt_t, UInt_t> MuonLumi;  // run, lumi
+
+struct MuonAnalyzerGlobalCache {
+  explicit MuonAnalyzerGlobalCache(const edm::ParameterSet& pset);
+
+  const MuonAnalyzerConfig                             config;
+  const std::vector<MuonSweepPoint>                    sweep;
+  const std::chrono::steady_clock::time_point          start;
+  const std::string                                    moduleLabel;
+  const std::string                                    checkpointFile;  // empty for none
+  const unsigned                                       checkpointEvents;
+  const double                                         checkpointMinutes;
+  mutable std::mutex                                   mutex;
+  mutable std::unique_ptr<MuonHistograms>              merged;
+  mutable std::vector<std::unique_ptr<MuonHistograms>> mergedSweep;  // one per sweep point
+  mutable MuonNtuple                                   ntuple;
+  mutable std::vector<MuonPerformance>                 performance;  // one per stream
+  mutable std::vector<MuonLumi>                        processedLumis;
+  mutable ULong64_t                                    eventsSinceCheckpoint;
+  mutable std::chrono::steady_clock::time_point        lastCheckpoint;
+};
+
+
+// Events of a lumi, summed over the streams
+struct MuonLumiSummary {
+  ULong64_t events = 0;
+};
+
+
+class ExampleMuonAnalyzer: public edm::stream::EDAnalyzer<edm::GlobalCache<MuonAnalyzerGlobalCache>,
+							   edm::LuminosityBlockSummaryCache<MuonLumiSummary>> {
  public:
   // Constructor
-  ExampleMuonAnalyzer(const edm::ParameterSet& pset);
+  ExampleMuonAnalyzer(const edm::ParameterSet& pset, const MuonAnalyzerGlobalCache* cache);
 
   // Destructor
   virtual ~ExampleMuonAnalyzer();
 
+  // Global cache
+  static std::unique_ptr<MuonAnalyzerGlobalCache> initializeGlobalCache(const edm::ParameterSet& pset);
+
+  static void globalEndJob(const MuonAnalyzerGlobalCache* cache);
+
+  // Lumi summary, used for the checkpoints
+  static std::shared_ptr<MuonLumiSummary> globalBeginLuminosityBlockSummary(const edm::LuminosityBlock& lumi,
+									     const edm::EventSetup&      eventSetup,
+									     const LuminosityBlockContext* context);
+
+  static void globalEndLuminosityBlockSummary(const edm::LuminosityBlock&   lumi,
+					      const edm::EventSetup&        eventSetup,
+					      const LuminosityBlockContext* context,
+					      MuonLumiSummary*              summary);
+
   // Operations
-  void analyze(const edm::Event & event, const edm::EventSetup& eventSetup);
+  void analyze(const edm::Event & event, const edm::EventSetup& eventSetup) override;
 
-  virtual void beginJob();
-  virtual void endJob();
+  void beginLuminosityBlock(const edm::LuminosityBlock& lumi, const edm::EventSetup& eventSetup) override;
+
+  void endLuminosityBlock(const edm::LuminosityBlock& lumi, const edm::EventSetup& eventSetup) override;
+
+  void endLuminosityBlockSummary(const edm::LuminosityBlock& lumi, const edm::EventSetup& eventSetup, MuonLumiSummary* summary) const;
+
+  void endStream() override;
  protected:
 
  private:
+  void flushNtuple();
+
+  // Add the stream histograms to the merged sets of the global cache
+  void mergeHistograms();
+
+  // Histograms of a selected gen muon, for the base configuration or a sweep point
+  void fillGenMuon(MuonHistograms&           histograms,
+		   const MuonAnalyzerConfig& cuts,
+		   const GenMuon&            gen,
+		   const MuonMatch         (&matches)[nMuonFlavours]);
+
+  // Isolation of the reco muons, in events with selected gen muons
+  void fillIsolation(MuonHistograms&           histograms,
+		     const MuonAnalyzerConfig& cuts);
+
+  // Memory held by the per-event buffers of the stream
+  std::size_t scratchBytes() const;
+
+  static const unsigned ntupleBatchSize = 10000;
+
   edm::EDGetTokenT<reco::BeamSpot>                    beamSpotToken;
   edm::EDGetTokenT<pat::MuonCollection>               muonToken;
-  edm::EDGetTokenT<edm::View<pat::PackedGenParticle>> packedGenToken;
-  edm::EDGetTokenT<edm::View<reco::GenParticle>>      prunedGenToken;
+  edm::EDGetTokenT<edm::View<pat::PackedGenParticle>> packedGenToken;  // only with genIsoDeltaR > 0
+  edm::EDGetTokenT<edm::View<reco::GenParticle>>      prunedGenToken;  // only with genMatching
+  edm::EDGetTokenT<pat::PackedCandidateCollection>    pfCandToken;     // only with tagAndProbe
   edm::EDGetTokenT<reco::VertexCollection>            vtxToken;
 
-  // TH1 histograms
-  TH1F* hGenMuons_eta;
-  TH1F* hGenMuons_phi;
-  TH1F* hGenMuons_pt;
-  TH1F* hGenMuons_vx;
-  TH1F* hGenMuons_vy;
-  TH1F* hGenMuons_vz;
-  TH1F* hGenMuons_vr;
-  
-  TH1F* hStaMuons_eta;
-  TH1F* hStaMuons_phi;
-  TH1F* hStaMuons_dR;
-  TH1F* hStaMuons_pt;
-  TH1F* hStaMuons_vr;
-  TH1F* hStaMuons_res[nbinspt];
-
-  TH1F* hStaMuons_noGen_eta;    
-  TH1F* hStaMuons_noGen_pt;                                                                                            
-  TH1F* hStaMuons_noGen_vr;
-
-  TH1F* hTrkMuons_eta;
-  TH1F* hTrkMuons_phi;
-  TH1F* hTrkMuons_dR;
-  TH1F* hTrkMuons_pt;
-  TH1F* hTrkMuons_vr;
-  TH1F* hTrkMuons_res[nbinspt];
-
-  TH1F* hTrkMuons_noGen_eta;                                                                                                        
-  TH1F* hTrkMuons_noGen_pt;                                                                                                         
-  TH1F* hTrkMuons_noGen_vr; 
-
-  TH1F* hGlbMuons_eta;
-  TH1F* hGlbMuons_phi;
-  TH1F* hGlbMuons_dR;
-  TH1F* hGlbMuons_pt;
-  TH1F* hGlbMuons_vr;
-  TH1F* hGlbMuons_res[nbinspt];
-
-  TH1F* hGlbMuons_noGen_eta;                                                                                                        
-  TH1F* hGlbMuons_noGen_pt;                                                                                                         
-  TH1F* hGlbMuons_noGen_vr; 
-
-  TH1F* hTightMuons_eta;                                                                                                           
-  TH1F* hTightMuons_phi;                                                                                                           
-  TH1F* hTightMuons_dR;                                                                                                            
-  TH1F* hTightMuons_pt;                                                                                                             
-  TH1F* hTightMuons_vr; 
-
-  TH1F* hIDMuons_noGen_eta;                                                                                                        
-  TH1F* hIDMuons_noGen_pt;                                                                                                          
-  TH1F* hIDMuons_noGen_vr; 
-
-  //isolation 
-  TH1F* hMuPFChargeIso; 
-  TH1F* hMuPFNeutralIso;
-  TH1F* hMuPFPhotonIso; 
-  TH1F* hMuPFPUIso;   
-  TH1F* hMuPFIso;
-  TH2F* hMuPFIso_R;    
-
-  // TH2 histograms
-  TH2F* hGenStaMuons_eta;
-  TH2F* hGenTrkMuons_eta;
-  TH2F* hGenGlbMuons_eta;
-
-  TH2F* hGenStaMuons_phi;
-  TH2F* hGenTrkMuons_phi;
-  TH2F* hGenGlbMuons_phi;}
-;
+  // Products consumed, read on demand after the gen pre-scan of analyze()
+  unsigned nProducts;
+
+  // Cuts and binning
+  const MuonAnalyzerConfig config;
+
+  // Histograms filled by this stream
+  MuonHistograms h;
+
+  // Per-event reco muon properties and gen-to-reco matching. These and the
+  // other per-event buffers below are reused from event to event, so that
+  // analyze() does not allocate once they have reached their peak size.
+  MuonTable   table;
+  MuonMatcher matcher;
+
+  // Tight, Soft and Medium bits evaluated for the table: those of the job and
+  // sweep selections, and all of them for the ntuple
+  std::uint8_t idMask;
+
+  // Per-event index of the packed gen particles, for the gen isolation
+  GenParticleGrid genGrid;
+
+  // Per-event impact parameters against the selected primary vertex, of the
+  // gen muons kept by the pre-scan (indices in the pruned collection in
+  // genMuons) and of the best track of every reco muon (indexed like the muon
+  // collection)
+  ImpactParameters      genImpact;
+  ImpactParameters      recoImpact;
+  std::vector<unsigned> genMuons;
+
+  // Per-event tag-probe pairs, the probes matched through matcher
+  MuonTagAndProbe tagProbe;
+
+  // Bootstrap weights of the current event, shared by all the histogram sets
+  BootstrapWeights bootstrapWeights;
+
+  // Sweep points, filled from the matches of the base configuration. The
+  // points with another ID selection take their ID flavour match from
+  // idMatchers[sweepMatcher-1], one per different selection, and 0 means the
+  // base matcher. maxVr is the largest of all the configurations, and
+  // sweepGenMuonsCut counts the gen muons within the maxVr of each point.
+  const std::vector<MuonSweepPoint>&           sweep;
+  std::vector<std::unique_ptr<MuonHistograms>> sweepHistograms;
+  std::vector<unsigned>                        sweepMatcher;
+  std::vector<const MuonAnalyzerConfig*>       idSelections;
+  std::vector<MuonMatcher>                     idMatchers;
+  std::vector<MuonMatch>                       idMatches;
+  double                                       maxVr;
+  std::vector<Int_t>                           sweepGenMuonsCut;
+
+  // Ntuple rows waiting to be written, and reco muons matched to a gen muon
+  bool                       writeNtuple;
+  std::vector<MuonNtupleRow> ntupleRows;
+  std::vector<std::uint8_t>  matchedMuon;
+
+  // Events of the current lumi
+  ULong64_t lumiEvents;
+
+  // Instrumentation
+  StageClock      clock;
+  MuonPerformance performance;
+};
 #endif
@@ -0,0 +1,58 @@
+#include "MuonAnalyzerConfig.h"
+
+
+namespace {
+
+  HistogramAxis makeAxis(Int_t nbins, Double_t min, Double_t max)
+  {
+    HistogramAxis axis;
+
+    axis.nbins = nbins;
+    axis.min   = min;
+    axis.max   = max;
+
+    return axis;
+  }
+}
+
+
+MuonAnalyzerConfig::MuonAnalyzerConfig() :
+  ptBins        ({10, 20, 35, 50}),
+  maxDeltaR     (0.3),
+  maxVr         (50),
+  maxEta        (2.4),
+  idBit         (kIsTight),
+  maxChargeIso  (-1),
+  nReplicas     (0),
+  genIsoDeltaR  (0),
+  genIsoMinPt   (0.5),
+  genMatching   (true),
+  tagAndProbe   (false),
+  tagMinPt      (26),
+  tagMaxIso     (0.15),
+  minMass       (70),
+  maxMass       (110),
+  eta           (makeAxis(100, -2.5, 2.5)),
+  phi           (makeAxis(100, -3.2, 3.2)),
+  pt            (makeAxis(100,    0, 100)),
+  vxyz          (makeAxis(150,    0, 750)),
+  vr            (makeAxis(750,    0, 750)),
+  dxy           (makeAxis(100,    0,  50)),
+  lxy           (makeAxis(150,    0, 750)),
+  ipSig         (makeAxis(100,    0, 100)),
+  dR            (makeAxis(100,    0,   4)),
+  res           (makeAxis( 60, -0.1, 0.1)),
+  staRes        (makeAxis( 60,   -1,   1)),
+  eta2D         (makeAxis( 50, -2.5, 2.5)),
+  phi2D         (makeAxis( 50, -3.2, 3.2)),
+  iso           (makeAxis(200,    0,   1)),
+  isoVr         (makeAxis(100,    0,  15)),
+  isoSumPt      (makeAxis(100,    0, 0.5)),
+  genNearestDR  (makeAxis( 80,    0, 0.4)),
+  mass          (makeAxis( 80,   70, 110)),
+  stageTime     (makeAxis(200,    0, 2000)),
+  multiplicity  (makeAxis(100,    0,  100)),
+  deltaRComputed(makeAxis(200,    0, 2000))
+{
+  for (Int_t f=0; f<nMuonFlavours; f++) flavourEnabled[f] = true;
+}
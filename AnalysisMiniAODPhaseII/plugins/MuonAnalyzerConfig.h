@@ -0,0 +1,138 @@
+#ifndef MuonAnalyzerConfig_H
+#define MuonAnalyzerConfig_H
+
+#include "MuonMatcher.h"
+#include "MuonTable.h"
+
+#include "Rtypes.h"
+
+#include <string>
+#include <vector>
+
+
+namespace edm {
+  class ParameterSet;
+}
+
+
+struct HistogramAxis {
+  Int_t    nbins;
+  Double_t min;
+  Double_t max;
+};
+
+
+//------------------------------------------------------------------------------
+// MuonAnalyzerConfig
+//
+// Cuts, pt bins, flavours and histogram axes of ExampleMuonAnalyzer. The
+// default constructor gives the historical values, the ParameterSet one reads
+// them from the muonAnalysis configuration. A sweep point is a copy of the
+// base configuration with some of the cuts changed, see MuonSweepPoint.
+//------------------------------------------------------------------------------
+class MuonAnalyzerConfig {
+ public:
+  MuonAnalyzerConfig();
+
+  explicit MuonAnalyzerConfig(const edm::ParameterSet& pset);
+
+  // Base configuration with the maxDeltaR, maxVr, id and maxChargeIso of point
+  MuonAnalyzerConfig(const MuonAnalyzerConfig& base, const edm::ParameterSet& point);
+
+  Int_t nPtBins() const { return ptBins.size() - 1; }
+
+  // Index of the pt bin strictly containing pt, -1 if none
+  Int_t ptBin(Float_t pt) const
+  {
+    for (Int_t i=0; i<nPtBins(); i++)
+      if (pt > ptBins[i] && pt < ptBins[i+1]) return i;
+
+    return -1;
+  }
+
+  Float_t minPt() const { return ptBins.front(); }
+
+  const char* idName() const { return (idBit == kIsSoft) ? "Soft" : (idBit == kIsMedium) ? "Medium" : "Tight"; }
+
+  // Charged isolation cut of the ID flavour and the isolation histograms
+  bool passesIso(Float_t chargeIso) const { return maxChargeIso < 0 || chargeIso <= maxChargeIso; }
+
+  // Same reco muons in the ID flavour
+  bool sameIdSelection(const MuonAnalyzerConfig& other) const
+  {
+    return idBit == other.idBit && maxChargeIso == other.maxChargeIso;
+  }
+
+  // Cuts
+  std::vector<double> ptBins;     // [GeV], variable width
+  double              maxDeltaR;
+  double              maxVr;      // [cm]
+  double              maxEta;
+  MuonIdBit           idBit;         // kIsTight, kIsSoft or kIsMedium
+  double              maxChargeIso;  // negative for no cut
+
+  // Poisson bootstrap replicas of the efficiency histograms, 0 for none
+  Int_t               nReplicas;
+
+  // Gen-level isolation cone of the gen muons, from the packed gen particles
+  // above genIsoMinPt [GeV], 0 for none
+  double              genIsoDeltaR;
+  double              genIsoMinPt;
+
+  // Gen-to-reco matching against the pruned gen particles, false for data
+  bool                genMatching;
+
+  // Tag-and-probe pairs: ID muons above tagMinPt [GeV] with a relative PF
+  // isolation below tagMaxIso as tags, the charged packed PF candidates as
+  // probes, and a mass in [minMass, maxMass] [GeV]
+  bool                tagAndProbe;
+  double              tagMinPt;
+  double              tagMaxIso;
+  double              minMass;
+  double              maxMass;
+
+  bool                flavourEnabled[nMuonFlavours];
+
+  // Histogram axes
+  HistogramAxis eta;
+  HistogramAxis phi;
+  HistogramAxis pt;
+  HistogramAxis vxyz;
+  HistogramAxis vr;
+  HistogramAxis dxy;    // |dxy| [cm], against the selected primary vertex
+  HistogramAxis lxy;    // [cm]
+  HistogramAxis ipSig;  // |dxy| and |dz| significances
+  HistogramAxis dR;
+  HistogramAxis res;
+  HistogramAxis staRes;
+  HistogramAxis eta2D;
+  HistogramAxis phi2D;
+  HistogramAxis iso;
+  HistogramAxis isoVr;
+  HistogramAxis isoSumPt;
+  HistogramAxis genNearestDR;
+  HistogramAxis mass;
+
+  // Instrumentation axes
+  HistogramAxis stageTime;     // [us]
+  HistogramAxis multiplicity;  // gen and reco muons per event
+  HistogramAxis deltaRComputed;
+};
+
+
+//------------------------------------------------------------------------------
+// MuonSweepPoint
+//
+// One point of a cut scan, filling its own muonAnalysis/<name> directory from
+// the same per-event matching as the base configuration.
+//------------------------------------------------------------------------------
+struct MuonSweepPoint {
+  std::string        name;
+  MuonAnalyzerConfig config;
+};
+
+
+// The points of the sweep VPSet, on top of base
+std::vector<MuonSweepPoint> readSweep(const edm::ParameterSet& pset, const MuonAnalyzerConfig& base);
+
+#endif
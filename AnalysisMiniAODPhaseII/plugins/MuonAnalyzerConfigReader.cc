@@ -0,0 +1,154 @@
+#include "MuonAnalyzerConfig.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+
+
+// Kept apart from MuonAnalyzerConfig.cc, which does not depend on CMSSW
+namespace {
+
+  HistogramAxis readAxis(const edm::ParameterSet& binning, const std::string& name)
+  {
+    const edm::ParameterSet& pset = binning.getParameter<edm::ParameterSet>(name);
+
+    HistogramAxis axis;
+
+    axis.nbins = pset.getParameter<int>   ("nbins");
+    axis.min   = pset.getParameter<double>("min");
+    axis.max   = pset.getParameter<double>("max");
+
+    if (axis.nbins < 1 || axis.max <= axis.min)
+      throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: bad binning for " << name << "\n";
+
+    return axis;
+  }
+
+
+  MuonIdBit readId(const std::string& name)
+  {
+    if (name == "Tight")  return kIsTight;
+    if (name == "Soft")   return kIsSoft;
+    if (name == "Medium") return kIsMedium;
+
+    throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: unknown id " << name << ", expected Tight, Soft or Medium\n";
+  }
+}
+
+
+MuonAnalyzerConfig::MuonAnalyzerConfig(const edm::ParameterSet& pset)
+{
+  ptBins    = pset.getParameter<std::vector<double>>("ptBins");
+  maxDeltaR = pset.getParameter<double>("maxDeltaR");
+  maxVr     = pset.getParameter<double>("maxVr");
+  maxEta    = pset.getParameter<double>("maxEta");
+
+  idBit        = readId(pset.getParameter<std::string>("id"));
+  maxChargeIso = pset.getParameter<double>("maxChargeIso");
+
+  nReplicas = pset.getParameter<int>("nReplicas");
+
+  if (nReplicas < 0)
+    throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: nReplicas cannot be negative\n";
+
+  genIsoDeltaR = pset.getParameter<double>("genIsoDeltaR");
+  genIsoMinPt  = pset.getParameter<double>("genIsoMinPt");
+
+  if (genIsoDeltaR < 0)
+    throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: genIsoDeltaR cannot be negative\n";
+
+  genMatching = pset.getParameter<bool>("genMatching");
+
+  tagAndProbe = pset.getParameter<bool>  ("tagAndProbe");
+  tagMinPt    = pset.getParameter<double>("tagMinPt");
+  tagMaxIso   = pset.getParameter<double>("tagMaxIso");
+  minMass     = pset.getParameter<double>("minMass");
+  maxMass     = pset.getParameter<double>("maxMass");
+
+  if (tagAndProbe && (minMass < 0 || maxMass <= minMass))
+    throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: bad tag-and-probe mass window\n";
+
+  if (!genMatching && genIsoDeltaR > 0)
+    throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: genIsoDeltaR needs genMatching\n";
+
+  if (ptBins.size() < 2 || !std::is_sorted(ptBins.begin(), ptBins.end()))
+    throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: ptBins needs at least two increasing edges\n";
+
+  for (Int_t f=0; f<nMuonFlavours; f++) flavourEnabled[f] = false;
+
+  for (const auto& name : pset.getParameter<std::vector<std::string>>("flavours")) {
+
+    Int_t f = std::find(muonFlavourNames, muonFlavourNames + nMuonFlavours, name) - muonFlavourNames;
+
+    if (f == nMuonFlavours)
+      throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: unknown muon flavour " << name << "\n";
+
+    flavourEnabled[f] = true;
+  }
+
+  const edm::ParameterSet& binning = pset.getParameter<edm::ParameterSet>("binning");
+
+  eta         = readAxis(binning, "eta");
+  phi         = readAxis(binning, "phi");
+  pt          = readAxis(binning, "pt");
+  vxyz        = readAxis(binning, "vxyz");
+  vr          = readAxis(binning, "vr");
+  dxy         = readAxis(binning, "dxy");
+  lxy         = readAxis(binning, "lxy");
+  ipSig       = readAxis(binning, "ipSig");
+  dR          = readAxis(binning, "dR");
+  res         = readAxis(binning, "res");
+  staRes      = readAxis(binning, "staRes");
+  eta2D       = readAxis(binning, "eta2D");
+  phi2D       = readAxis(binning, "phi2D");
+  iso         = readAxis(binning, "iso");
+  isoVr       = readAxis(binning, "isoVr");
+  isoSumPt    = readAxis(binning, "isoSumPt");
+
+  genNearestDR = readAxis(binning, "genNearestDR");
+  mass         = readAxis(binning, "mass");
+
+  stageTime      = readAxis(binning, "stageTime");
+  multiplicity   = readAxis(binning, "multiplicity");
+  deltaRComputed = readAxis(binning, "deltaRComputed");
+}
+
+
+MuonAnalyzerConfig::MuonAnalyzerConfig(const MuonAnalyzerConfig& base, const edm::ParameterSet& point) :
+  MuonAnalyzerConfig(base)
+{
+  // Only the cuts applied after the matching, or to the ID flavour, can change
+  for (const auto& name : point.getParameterNames()) {
+    if (name != "name" && name != "maxDeltaR" && name != "maxVr" && name != "id" && name != "maxChargeIso")
+      throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: sweep points cannot change " << name << "\n";
+  }
+
+  if (point.existsAs<double>("maxDeltaR"))    maxDeltaR    = point.getParameter<double>("maxDeltaR");
+  if (point.existsAs<double>("maxVr"))        maxVr        = point.getParameter<double>("maxVr");
+  if (point.existsAs<double>("maxChargeIso")) maxChargeIso = point.getParameter<double>("maxChargeIso");
+
+  if (point.existsAs<std::string>("id")) idBit = readId(point.getParameter<std::string>("id"));
+}
+
+
+std::vector<MuonSweepPoint> readSweep(const edm::ParameterSet& pset, const MuonAnalyzerConfig& base)
+{
+  std::vector<MuonSweepPoint> sweep;
+
+  for (const auto& point : pset.getParameter<std::vector<edm::ParameterSet>>("sweep")) {
+
+    const std::string name = point.getParameter<std::string>("name");
+
+    if (name.empty() || name == "instrumentation")
+      throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: bad sweep point name '" << name << "'\n";
+
+    for (const auto& other : sweep)
+      if (other.name == name)
+	throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: duplicate sweep point " << name << "\n";
+
+    sweep.push_back(MuonSweepPoint{name, MuonAnalyzerConfig(base, point)});
+  }
+
+  return sweep;
+}
@@ -0,0 +1,222 @@
+#include "MuonCheckpoint.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "TClass.h"
+#include "TDirectory.h"
+#include "TFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+using namespace std;
+
+
+namespace {
+
+  // TFileService-like directory of a checkpoint file being written
+  struct CheckpointWriter {
+    TDirectory* directory;
+
+    template <typename T, typename... Args> T* make(const Args&... args) const
+    {
+      T* object = new T(args...);
+
+      ROOT::DirAutoAdd_t add = T::Class()->GetDirectoryAutoAdd();
+
+      if (add)
+	add(object, directory);
+      else
+	directory->Append(object);
+
+      return object;
+    }
+
+    CheckpointWriter mkdir(const std::string& name) const { return CheckpointWriter{directory->mkdir(name.c_str())}; }
+  };
+
+
+  // Hands out the histograms of a checkpoint directory, detached from the file
+  struct CheckpointReader {
+    TDirectory* directory;
+
+    template <typename T, typename Name, typename... Args> T* make(const Name& name, const Args&...) const
+    {
+      T* object = dynamic_cast<T*>(directory->Get(TString(name)));
+
+      if (!object)
+	throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: no " << TString(name) << " in " << directory->GetPath()
+					      << ", the checkpoint was made with another configuration\n";
+
+      object->SetDirectory(nullptr);
+
+      return object;
+    }
+  };
+
+
+  TDirectory* checkpointDirectory(TDirectory* parent, const std::string& name)
+  {
+    TDirectory* directory = parent->GetDirectory(name.c_str());
+
+    if (!directory)
+      throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: no " << name << " directory in " << parent->GetPath() << "\n";
+
+    return directory;
+  }
+
+
+  // The checkpoint must have the cuts of the job it resumes
+  void checkCuts(TDirectory* directory, const MuonAnalyzerConfig& config)
+  {
+    const char* const names [] = {"maxDeltaR",      "maxVr",      "maxEta",      "maxChargeIso",      "genIsoDeltaR",
+				  "minMass",        "maxMass"};
+    const double      values[] = {config.maxDeltaR, config.maxVr, config.maxEta, config.maxChargeIso, config.genIsoDeltaR,
+				  config.tagAndProbe ? config.minMass : 0, config.tagAndProbe ? config.maxMass : 0};
+
+    for (Int_t i=0; i<7; i++) {
+
+      TParameter<double>* cut = dynamic_cast<TParameter<double>*>(directory->Get(names[i]));
+
+      if (!cut || cut->GetVal() != values[i])
+	throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: " << names[i] << " of " << directory->GetPath() << " differs from the job configuration\n";
+
+      delete cut;
+    }
+
+    TNamed* id = dynamic_cast<TNamed*>(directory->Get("Id"));
+
+    if (!id || TString(id->GetTitle()) != config.idName())
+      throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: Id of " << directory->GetPath() << " differs from the job configuration\n";
+
+    delete id;
+  }
+
+
+  // Lumi ranges as accepted by the lumisToSkip of PoolSource, 1:2-1:5,1:8-1:8
+  std::string formatLumis(std::vector<MuonLumi> lumis)
+  {
+    std::sort(lumis.begin(), lumis.end());
+
+    std::ostringstream ranges;
+
+    for (size_t i=0; i<lumis.size(); ) {
+
+      size_t j = i;
+
+      while (j+1 < lumis.size() && lumis[j+1].first == lumis[i].first && lumis[j+1].second <= lumis[j].second + 1) j++;
+
+      ranges << (i ? "," : "") << lumis[i].first << ":" << lumis[i].second << "-" << lumis[j].first << ":" << lumis[j].second;
+
+      i = j + 1;
+    }
+
+    return ranges.str();
+  }
+
+
+  std::vector<MuonLumi> parseLumis(const std::string& ranges)
+  {
+    std::vector<MuonLumi> lumis;
+
+    std::istringstream stream(ranges);
+    std::string        range;
+
+    while (std::getline(stream, range, ',')) {
+
+      UInt_t run, first, last;
+
+      if (sscanf(range.c_str(), "%u:%u-%*u:%u", &run, &first, &last) != 3)
+	throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: bad lumi range " << range << " in the checkpoint\n";
+
+      for (UInt_t lumi=first; lumi<=last; lumi++) lumis.push_back(MuonLumi(run, lumi));
+    }
+
+    return lumis;
+  }
+}
+
+
+void writeCheckpoint(const MuonAnalyzerGlobalCache* cache)
+{
+  // Through a temporary file renamed at the end, so that the checkpoint is
+  // never half written
+  const std::string temporary = cache->checkpointFile + ".tmp";
+
+  TDirectory::TContext context;  // leaves gDirectory as it was
+
+  TFile* file = TFile::Open(temporary.c_str(), "recreate");
+
+  if (!file || file->IsZombie()) {
+    cout << " [ExampleMuonAnalyzer::writeCheckpoint] cannot create " << temporary << ", no checkpoint written" << endl;
+    delete file;
+    return;
+  }
+
+  CheckpointWriter directory{file->mkdir(cache->moduleLabel.c_str())};
+
+  CheckpointWriter instrumentation = directory.mkdir("instrumentation");
+
+  writeHistograms(directory, instrumentation, cache);
+
+  directory.make<TNamed>("ProcessedLumis", formatLumis(cache->processedLumis).c_str());
+
+  file->Write();
+  file->Close();
+
+  delete file;
+
+  if (std::rename(temporary.c_str(), cache->checkpointFile.c_str()) != 0) {
+    cout << " [ExampleMuonAnalyzer::writeCheckpoint] cannot rename " << temporary << " to " << cache->checkpointFile << endl;
+    return;
+  }
+
+  cout << " [ExampleMuonAnalyzer::writeCheckpoint] " << cache->processedLumis.size() << " lumis in " << cache->checkpointFile << endl;
+}
+
+
+void resumeCheckpoint(MuonAnalyzerGlobalCache* cache, const std::string& filename)
+{
+  TDirectory::TContext context;
+
+  std::unique_ptr<TFile> file(TFile::Open(filename.c_str()));
+
+  if (!file || file->IsZombie())
+    throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: cannot open the checkpoint " << filename << "\n";
+
+  TDirectory* top = checkpointDirectory(file.get(), cache->moduleLabel);
+
+  TNamed* lumis = dynamic_cast<TNamed*>(top->Get("ProcessedLumis"));
+
+  if (!lumis)
+    throw cms::Exception("Configuration") << "ExampleMuonAnalyzer: " << filename << " is not a checkpoint, it has no ProcessedLumis\n";
+
+  cache->processedLumis = parseLumis(lumis->GetTitle());
+
+  delete lumis;
+
+  checkCuts(top, cache->config);
+
+  CheckpointReader directory      {top};
+  CheckpointReader instrumentation{checkpointDirectory(top, "instrumentation")};
+
+  cache->merged.reset(new MuonHistograms());
+  cache->merged->bookOwned(directory, instrumentation, cache->config);
+
+  for (const auto& point : cache->sweep) {
+
+    TDirectory* subdirectory = checkpointDirectory(top, point.name);
+
+    checkCuts(subdirectory, point.config);
+
+    CheckpointReader reader{subdirectory};
+
+    cache->mergedSweep.emplace_back(new MuonHistograms());
+    cache->mergedSweep.back()->bookOwned(reader, point.config);
+  }
+
+  cout << " [ExampleMuonAnalyzer::resumeCheckpoint] " << cache->processedLumis.size() << " lumis from " << filename << endl;
+}
@@ -0,0 +1,75 @@
+#ifndef MuonCheckpoint_H
+#define MuonCheckpoint_H
+
+#include "MuonAnalyzer.h"
+
+#include "TH1D.h"
+#include "TNamed.h"
+#include "TParameter.h"
+#include "TString.h"
+
+#include <string>
+
+
+// Cuts of a configuration, for the plotting macros
+template <class Directory> void writeCuts(Directory& directory, const MuonAnalyzerConfig& config)
+{
+  directory.template make<TParameter<double>>("maxDeltaR",    config.maxDeltaR,    'f');
+  directory.template make<TParameter<double>>("maxVr",        config.maxVr,        'f');
+  directory.template make<TParameter<double>>("maxEta",       config.maxEta,       'f');
+  directory.template make<TParameter<double>>("maxChargeIso", config.maxChargeIso, 'f');
+  directory.template make<TParameter<double>>("genIsoDeltaR", config.genIsoDeltaR, 'f');
+  directory.template make<TParameter<double>>("minMass",      config.tagAndProbe ? config.minMass : 0, 'f');
+  directory.template make<TParameter<double>>("maxMass",      config.tagAndProbe ? config.maxMass : 0, 'f');
+  directory.template make<TNamed>("Id", config.idName());
+}
+
+
+// Histograms, cuts and binning of the base configuration and the sweep
+// points, as in the job output
+template <class Directory> void writeHistograms(Directory& directory, Directory& instrumentation, const MuonAnalyzerGlobalCache* cache)
+{
+  const MuonAnalyzerConfig& config = cache->config;
+
+  MuonHistograms output;
+
+  output.book(directory, instrumentation, config);
+
+  if (cache->merged) output.add(*cache->merged);
+
+  directory.template make<TH1D>("PtBins", "p_{T} bins", config.nPtBins(), config.ptBins.data());
+
+  writeCuts(directory, config);
+
+  TString flavours;
+
+  for (Int_t f=0; f<nMuonFlavours; f++)
+    if (config.flavourEnabled[f]) flavours += TString(flavours.IsNull() ? "" : " ") + muonFlavourNames[f];
+
+  directory.template make<TNamed>("Flavours", flavours.Data());
+
+  // Sweep points, one directory each
+  for (size_t p=0; p<cache->sweep.size(); p++) {
+
+    const MuonSweepPoint& point = cache->sweep[p];
+
+    Directory subdirectory = directory.mkdir(point.name);
+
+    MuonHistograms histograms;
+
+    histograms.book(subdirectory, point.config);
+
+    if (!cache->mergedSweep.empty()) histograms.add(*cache->mergedSweep[p]);
+
+    writeCuts(subdirectory, point.config);
+  }
+}
+
+
+// Merged sets and processed lumis, written to cache->checkpointFile
+void writeCheckpoint(const MuonAnalyzerGlobalCache* cache);
+
+// Start from the histograms and lumis of a checkpoint
+void resumeCheckpoint(MuonAnalyzerGlobalCache* cache, const std::string& filename);
+
+#endif
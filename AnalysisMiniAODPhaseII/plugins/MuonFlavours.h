@@ -0,0 +1,134 @@
+#ifndef MuonFlavours_H
+#define MuonFlavours_H
+
+#include "MuonAnalyzerConfig.h"
+#include "MuonMatcher.h"
+#include "MuonTable.h"
+
+#include <tuple>
+
+
+//------------------------------------------------------------------------------
+// Muon flavour descriptors
+//
+// Each flavour says which reco muons it selects, which track gives their
+// kinematics and how its histograms are named. The analyzer instantiates the
+// same extraction and match-and-fill code for every entry of MuonFlavourTable,
+// so adding a flavour means a MuonFlavour value, a descriptor and a table
+// entry. The track accessors are templates, this header does not need the
+// pat::Muon definition.
+//------------------------------------------------------------------------------
+struct MuonKinematics {
+  float eta;
+  float phi;
+  float pt;
+  float charge;
+};
+
+
+template <class Track> MuonKinematics kinematicsOf(const Track& track)
+{
+  MuonKinematics k;
+
+  k.eta    = track.eta();
+  k.phi    = track.phi();
+  k.pt     = track.pt();
+  k.charge = track.charge();
+
+  return k;
+}
+
+
+// isTightMuon, or the isSoftMuon / isMediumMuon of config.idBit, with the
+// optional charged isolation cut
+struct TightFlavour {
+  static const MuonFlavour flavour       = kTight;
+  static const bool        hasResolution = false;
+
+  static const char* name()      { return "Tight"; }  // matched histograms
+  static const char* noGenName() { return "ID"; }     // noGen histograms
+  static const char* label()     { return "ID"; }     // histogram titles
+
+  static bool select(const MuonTable& table, unsigned j, const MuonAnalyzerConfig& config)
+  {
+    return table.has(j, config.idBit) && config.passesIso(table.chargeIso[j]);
+  }
+
+  template <class Muon> static MuonKinematics track(const Muon& muon) { return kinematicsOf(muon); }
+
+  static const HistogramAxis& resAxis(const MuonAnalyzerConfig& config) { return config.res; }
+};
+
+
+// isStandAloneMuon
+struct StaFlavour {
+  static const MuonFlavour flavour       = kSta;
+  static const bool        hasResolution = true;
+
+  static const char* name()      { return "Sta"; }
+  static const char* noGenName() { return "Sta"; }
+  static const char* label()     { return "sta"; }
+
+  static bool select(const MuonTable& table, unsigned j, const MuonAnalyzerConfig&) { return table.has(j, kIsStandAlone); }
+
+  template <class Muon> static MuonKinematics track(const Muon& muon) { return kinematicsOf(*muon.standAloneMuon()); }
+
+  static const HistogramAxis& resAxis(const MuonAnalyzerConfig& config) { return config.staRes; }
+};
+
+
+// isTrackerMuon
+struct TrkFlavour {
+  static const MuonFlavour flavour       = kTrk;
+  static const bool        hasResolution = true;
+
+  static const char* name()      { return "Trk"; }
+  static const char* noGenName() { return "Trk"; }
+  static const char* label()     { return "trk"; }
+
+  static bool select(const MuonTable& table, unsigned j, const MuonAnalyzerConfig&) { return table.has(j, kIsTracker); }
+
+  template <class Muon> static MuonKinematics track(const Muon& muon) { return kinematicsOf(*muon.innerTrack()); }
+
+  static const HistogramAxis& resAxis(const MuonAnalyzerConfig& config) { return config.res; }
+};
+
+
+// isGlobalMuon && isStandAloneMuon
+struct GlbFlavour {
+  static const MuonFlavour flavour       = kGlb;
+  static const bool        hasResolution = true;
+
+  static const char* name()      { return "Glb"; }
+  static const char* noGenName() { return "Glb"; }
+  static const char* label()     { return "glb"; }
+
+  static bool select(const MuonTable& table, unsigned j, const MuonAnalyzerConfig&) { return table.has(j, kIsGlobal) && table.has(j, kIsStandAlone); }
+
+  template <class Muon> static MuonKinematics track(const Muon& muon) { return kinematicsOf(*muon.globalTrack()); }
+
+  static const HistogramAxis& resAxis(const MuonAnalyzerConfig& config) { return config.res; }
+};
+
+
+typedef std::tuple<TightFlavour, StaFlavour, TrkFlavour, GlbFlavour> MuonFlavourTable;
+
+
+// Calls function(Flavour()) for every flavour of the table, unrolled at
+// compile time
+template <class Function, class... Flavours>
+void forEachFlavour(Function&& function, std::tuple<Flavours...>*)
+{
+  int expand[] = {0, (function(Flavours()), 0)...};
+
+  (void)expand;
+}
+
+
+template <class Function>
+void forEachFlavour(Function&& function)
+{
+  forEachFlavour(function, (MuonFlavourTable*)nullptr);
+}
+
+#endif
@@ -0,0 +1,104 @@
+#include "MuonHistograms.h"
+
+
+namespace {
+
+  // Books histograms outside of any ROOT directory, so that several streams
+  // can own copies with the same names
+  struct DetachedDirectory {
+    template <typename T, typename... Args> T* make(const Args&... args) const
+    {
+      T* h = new T(args...);
+      h->SetDirectory(nullptr);
+      return h;
+    }
+  };
+}
+
+
+MuonHistograms::MuonHistograms() :
+  flavours(),
+  hGenMuonIso(nullptr),
+  hGenMuonChargeIso(nullptr),
+  hGenMuonNeutralIso(nullptr),
+  hGenMuonIso_R(nullptr),
+  hGenMuonNearestDR(nullptr),
+  hGenMuonConeParticles(nullptr),
+  hMuPFIso_GenIso(nullptr),
+  tagProbe(),
+  hTagProbeMass(nullptr),
+  hTagProbePairs(nullptr),
+  hProbesPerEvent(nullptr),
+  owned(false),
+  nReplicas(0),
+  weights(nullptr)
+{
+}
+
+
+MuonHistograms::~MuonHistograms()
+{
+  if (owned) for (auto h : all) delete h;
+}
+
+
+void MuonHistograms::bookDetached(const MuonAnalyzerConfig& config, bool instrumentation, const BootstrapWeights* weights)
+{
+  DetachedDirectory directory;
+
+  owned = true;
+
+  this->weights = weights;
+
+  if (instrumentation)
+    book(directory, directory, config);
+  else
+    book(directory, config);
+}
+
+
+void MuonHistograms::flush()
+{
+  for (const auto& b : buffers1D) b->flush();
+  for (const auto& b : buffers2D) b->flush();
+}
+
+
+void MuonHistograms::reset()
+{
+  for (const auto& b : buffers1D) b->reset();
+  for (const auto& b : buffers2D) b->reset();
+}
+
+
+void MuonHistograms::add(const MuonHistograms& other)
+{
+  for (size_t i=0; i<all.size(); i++) all[i]->Add(other.all[i]);
+}
+
+
+void MuonHistograms::fillGen(const GenMuon& gen)
+{
+  hGenMuons_eta->Fill(gen.eta);
+  hGenMuons_phi->Fill(gen.phi);
+  hGenMuons_pt ->Fill(gen.pt);
+  hGenMuons_vx ->Fill(std::fabs(gen.vx));
+  hGenMuons_vy ->Fill(std::fabs(gen.vy));
+  hGenMuons_vz ->Fill(std::fabs(gen.vz));
+  hGenMuons_vr ->Fill(gen.vr);
+  hGenMuons_dxy->Fill(std::fabs(gen.dxy));
+  hGenMuons_lxy->Fill(gen.lxy);
+}
+
+
+std::size_t MuonHistograms::bytes() const
+{
+  std::size_t bytes = 0;
+
+  for (auto h : all) bytes += h->GetNcells() * (sizeof(Float_t) + (h->GetSumw2N() > 0 ? sizeof(Double_t) : 0));
+
+  for (const auto& b : buffers1D) bytes += b->bytes();
+  for (const auto& b : buffers2D) bytes += b->bytes();
+
+  return bytes;
+}
@@ -0,0 +1,467 @@
+#ifndef MuonHistograms_H
+#define MuonHistograms_H
+
+#include "FixedAxisHistogram.h"
+#include "GenParticleGrid.h"
+#include "MuonAnalyzerConfig.h"
+#include "MuonFlavours.h"
+#include "MuonInstrumentation.h"
+#include "MuonMatcher.h"
+
+#include "TH1F.h"
+#include "TH2F.h"
+#include "TString.h"
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+class TH1;
+
+
+// Kinematics of a selected gen muon
+struct GenMuon {
+  Float_t charge;
+  Float_t eta;
+  Float_t phi;
+  Float_t pt;
+  Float_t vx;
+  Float_t vy;
+  Float_t vz;
+  Float_t vr;
+  Float_t dxy;    // impact parameters against the selected primary vertex, see ImpactParameters
+  Float_t dz;
+  Float_t lxy;
+  Int_t   ptBin;  // MuonAnalyzerConfig::ptBin(pt)
+
+  GenIsolation isolation;  // filled when config.genIsoDeltaR > 0
+};
+
+
+// Histograms of one reco muon flavour. The resolution and gen-vs-reco TH2
+// histograms are only booked for flavours with Flavour::hasResolution.
+struct FlavourHistograms {
+  FixedAxisHistogram1D* eta;
+  FixedAxisHistogram1D* phi;
+  FixedAxisHistogram1D* dR;
+  FixedAxisHistogram1D* pt;
+  FixedAxisHistogram1D* vr;
+  FixedAxisHistogram1D* dxy;
+  FixedAxisHistogram1D* lxy;
+
+  FixedAxisHistogram1D* noGen_eta;
+  FixedAxisHistogram1D* noGen_pt;
+  FixedAxisHistogram1D* noGen_vr;
+  FixedAxisHistogram1D* noGen_dxy;
+  FixedAxisHistogram1D* noGen_lxy;
+
+  std::vector<FixedAxisHistogram1D*> res;  // one per pt bin
+
+  FixedAxisHistogram2D* genEta;
+  FixedAxisHistogram2D* genPhi;
+};
+
+
+// Tag-and-probe histograms of one reco muon flavour: the pair mass against the
+// probe pt, eta and |dxy| (on the vr axis), for the probes matched to a muon
+// of the flavour and for the others
+struct TagProbeHistograms {
+  FixedAxisHistogram2D* pass_pt;
+  FixedAxisHistogram2D* pass_eta;
+  FixedAxisHistogram2D* pass_vr;
+
+  FixedAxisHistogram2D* fail_pt;
+  FixedAxisHistogram2D* fail_eta;
+  FixedAxisHistogram2D* fail_vr;
+};
+
+
+//------------------------------------------------------------------------------
+// MuonHistograms
+//
+// The ExampleMuonAnalyzer histograms. Each stream fills a detached copy, and
+// the copies are added into a set booked through TFileService.
+//------------------------------------------------------------------------------
+class MuonHistograms {
+ public:
+  MuonHistograms();
+
+  ~MuonHistograms();
+
+  // Book through TFileService-like directories (anything with make<T>(...)),
+  // the instrumentation histograms in their own subdirectory
+  template <class Directory, class Subdirectory>
+    void book(Directory& directory, Subdirectory& instrumentation, const MuonAnalyzerConfig& config);
+
+  // Same without the instrumentation histograms, for the sweep points
+  template <class Directory>
+    void book(Directory& directory, const MuonAnalyzerConfig& config);
+
+  // Book histograms that are not attached to any ROOT directory. The replicas
+  // are only filled when the weights are given.
+  void bookDetached(const MuonAnalyzerConfig& config,
+		    bool                      instrumentation = true,
+		    const BootstrapWeights*   weights         = nullptr);
+
+  // Book through directories handing out histograms that the set then owns,
+  // such as the ones read back from a checkpoint
+  template <class Directory, class Subdirectory>
+    void bookOwned(Directory& directory, Subdirectory& instrumentation, const MuonAnalyzerConfig& config);
+
+  template <class Directory>
+    void bookOwned(Directory& directory, const MuonAnalyzerConfig& config);
+
+  // Copy the fill buffers into the booked histograms
+  void flush();
+
+  // Empty the fill buffers, once their content has been added elsewhere
+  void reset();
+
+  // Add the content of another, identically booked, set
+  void add(const MuonHistograms& other);
+
+  // Fill the gen muon kinematics
+  void fillGen(const GenMuon& gen);
+
+  // Fill the histograms of one flavour with the closest reco muon to a gen
+  // muon, instantiated for each entry of MuonFlavourTable
+  template <class Flavour> void fill(const MuonMatch& match, const GenMuon& gen, const MuonAnalyzerConfig& config);
+
+  // Fill the tag-and-probe histograms of one flavour with a pair, the probe
+  // passing when match is within maxDeltaR
+  template <class Flavour> void fillTagProbe(const MuonMatch&          match,
+					     Float_t                   mass,
+					     Float_t                   probePt,
+					     Float_t                   probeEta,
+					     Float_t                   probeDxy,
+					     const MuonAnalyzerConfig& config);
+
+  // Memory held by the histograms and their buffers
+  std::size_t bytes() const;
+
+  // TH1 histograms
+  FixedAxisHistogram1D* hGenMuons_eta;
+  FixedAxisHistogram1D* hGenMuons_phi;
+  FixedAxisHistogram1D* hGenMuons_pt;
+  FixedAxisHistogram1D* hGenMuons_vx;
+  FixedAxisHistogram1D* hGenMuons_vy;
+  FixedAxisHistogram1D* hGenMuons_vz;
+  FixedAxisHistogram1D* hGenMuons_vr;
+  FixedAxisHistogram1D* hGenMuons_dxy;
+  FixedAxisHistogram1D* hGenMuons_lxy;
+
+  FlavourHistograms flavours[nMuonFlavours];  // indexed by MuonFlavour
+
+  // Isolation
+  FixedAxisHistogram1D* hMuPFChargeIso;
+  FixedAxisHistogram1D* hMuPFNeutralIso;
+  FixedAxisHistogram1D* hMuPFPhotonIso;
+  FixedAxisHistogram1D* hMuPFPUIso;
+  FixedAxisHistogram1D* hMuPFIso;
+  FixedAxisHistogram2D* hMuPFIso_R;
+
+  // Gen isolation of the gen muons, relative to their pt, and the reco
+  // isolation of the ID-matched muon against it
+  FixedAxisHistogram1D* hGenMuonIso;
+  FixedAxisHistogram1D* hGenMuonChargeIso;
+  FixedAxisHistogram1D* hGenMuonNeutralIso;
+  FixedAxisHistogram2D* hGenMuonIso_R;
+  FixedAxisHistogram1D* hGenMuonNearestDR;
+  FixedAxisHistogram1D* hGenMuonConeParticles;
+  FixedAxisHistogram2D* hMuPFIso_GenIso;
+
+  // Impact parameters of the ID-matched reco muon against the selected
+  // primary vertex: |dxy| and |dz| significances, and |dxy| against the gen one
+  FixedAxisHistogram1D* hMuDxySig;
+  FixedAxisHistogram1D* hMuDzSig;
+  FixedAxisHistogram2D* hMuDxy_GenDxy;
+
+  // Tag-and-probe pairs
+  TagProbeHistograms    tagProbe[nMuonFlavours];  // indexed by MuonFlavour
+  FixedAxisHistogram1D* hTagProbeMass;
+  FixedAxisHistogram1D* hTagProbePairs;
+
+  // Instrumentation: wall-clock time per stage [us], and counters per event,
+  // not booked for the sweep points
+  FixedAxisHistogram1D* hStageTime[nMuonStages];
+  FixedAxisHistogram1D* hGenMuonsPerEvent;
+  FixedAxisHistogram1D* hRecoMuonsPerEvent;
+  FixedAxisHistogram1D* hDeltaRPerEvent;
+  FixedAxisHistogram1D* hProbesPerEvent;
+
+ private:
+  MuonHistograms(const MuonHistograms&) = delete;
+  MuonHistograms& operator=(const MuonHistograms&) = delete;
+
+  template <class Directory>
+    FixedAxisHistogram1D* book1D(Directory& directory, const char* name, const char* title, const HistogramAxis& x, bool replicated = false);
+
+  template <class Directory>
+    FixedAxisHistogram2D* book2D(Directory& directory, const char* name, const char* title, const HistogramAxis& x, const HistogramAxis& y);
+
+  template <class Flavour, class Directory>
+    void bookFlavour(Directory& directory, const MuonAnalyzerConfig& config);
+
+  template <class Flavour, class Directory>
+    void bookTagProbe(Directory& directory, const MuonAnalyzerConfig& config);
+
+  std::vector<TH1*> all;    // booking order, used to pair histograms in add()
+  bool              owned;  // true for detached histograms
+
+  Int_t                   nReplicas;
+  const BootstrapWeights* weights;
+
+  std::vector<std::unique_ptr<FixedAxisHistogram1D>> buffers1D;
+  std::vector<std::unique_ptr<FixedAxisHistogram2D>> buffers2D;
+};
+
+
+template <class Directory>
+FixedAxisHistogram1D* MuonHistograms::book1D(Directory& directory, const char* name, const char* title, const HistogramAxis& x, bool replicated)
+{
+  TH1F* h = directory.template make<TH1F>(name, title, x.nbins, x.min, x.max);
+
+  all.push_back(h);
+
+  buffers1D.emplace_back(new FixedAxisHistogram1D(h));
+
+  if (!replicated || nReplicas == 0) return buffers1D.back().get();
+
+  TH2F* replicas = directory.template make<TH2F>(TString(name) + "_replicas", TString(title) + ", bootstrap replicas", x.nbins, x.min, x.max, nReplicas, 0, nReplicas);
+
+  all.push_back(replicas);
+
+  if (weights) buffers1D.back()->bootstrap(replicas, weights);
+
+  return buffers1D.back().get();
+}
+
+
+template <class Directory>
+FixedAxisHistogram2D* MuonHistograms::book2D(Directory& directory, const char* name, const char* title, const HistogramAxis& x, const HistogramAxis& y)
+{
+  TH2F* h = directory.template make<TH2F>(name, title, x.nbins, x.min, x.max, y.nbins, y.min, y.max);
+
+  all.push_back(h);
+
+  buffers2D.emplace_back(new FixedAxisHistogram2D(h));
+
+  return buffers2D.back().get();
+}
+
+
+template <class Directory, class Subdirectory>
+void MuonHistograms::bookOwned(Directory& directory, Subdirectory& instrumentation, const MuonAnalyzerConfig& config)
+{
+  owned = true;
+
+  book(directory, instrumentation, config);
+}
+
+
+template <class Directory>
+void MuonHistograms::bookOwned(Directory& directory, const MuonAnalyzerConfig& config)
+{
+  owned = true;
+
+  book(directory, config);
+}
+
+
+template <class Directory, class Subdirectory>
+void MuonHistograms::book(Directory& directory, Subdirectory& instrumentation, const MuonAnalyzerConfig& config)
+{
+  book(directory, config);
+
+  // Instrumentation
+  for (Int_t s=0; s<nMuonStages; s++)
+    hStageTime[s] = book1D(instrumentation, Form("Time_%s", muonStageNames[s]), Form("%s stage wall-clock time per event [#mus]", muonStageNames[s]), config.stageTime);
+
+  hGenMuonsPerEvent  = book1D(instrumentation, "GenMuonsPerEvent",  "selected gen muons per event",    config.multiplicity);
+  hRecoMuonsPerEvent = book1D(instrumentation, "RecoMuonsPerEvent", "reco muons per event",            config.multiplicity);
+  hDeltaRPerEvent    = book1D(instrumentation, "DeltaRPerEvent",    "gen-reco dR evaluations per event", config.deltaRComputed);
+
+  // Tag and probe
+  if (!config.tagAndProbe) return;
+
+  forEachFlavour([&](auto flavour)
+    {
+      typedef decltype(flavour) Flavour;
+
+      if (config.flavourEnabled[Flavour::flavour]) this->template bookTagProbe<Flavour>(directory, config);
+    });
+
+  hTagProbeMass   = book1D(directory,       "TnP_mass",       "tag-probe pair mass [GeV]",      config.mass);
+  hTagProbePairs  = book1D(directory,       "TnP_pairs",      "tag-probe pairs per event",      config.multiplicity);
+  hProbesPerEvent = book1D(instrumentation, "ProbesPerEvent", "tag-and-probe probes per event", config.multiplicity);
+}
+
+
+template <class Directory>
+void MuonHistograms::book(Directory& directory, const MuonAnalyzerConfig& config)
+{
+  nReplicas = config.nReplicas;
+
+  // TH1 histograms
+  hGenMuons_eta = book1D(directory, "GenMuons_eta", "gen muons eta",   config.eta, true);
+  hGenMuons_phi = book1D(directory, "GenMuons_phi", "gen muons phi",   config.phi);
+  hGenMuons_pt  = book1D(directory, "GenMuons_pt",  "gen muons pt",    config.pt,  true);
+  hGenMuons_vx  = book1D(directory, "GenMuons_vx",  "gen muons vx",    config.vxyz);
+  hGenMuons_vy  = book1D(directory, "GenMuons_vy",  "gen muons vy",    config.vxyz);
+  hGenMuons_vz  = book1D(directory, "GenMuons_vz",  "gen muons vz",    config.vxyz);
+  hGenMuons_vr  = book1D(directory, "GenMuons_vr",  "gen muons vr",    config.vr,  true);
+  hGenMuons_dxy = book1D(directory, "GenMuons_dxy", "gen muons |dxy|", config.dxy, true);
+  hGenMuons_lxy = book1D(directory, "GenMuons_lxy", "gen muons Lxy",   config.lxy, true);
+
+  forEachFlavour([&](auto flavour)
+    {
+      typedef decltype(flavour) Flavour;
+
+      if (config.flavourEnabled[Flavour::flavour]) this->template bookFlavour<Flavour>(directory, config);
+    });
+
+  // Isolation
+  hMuPFChargeIso  = book1D(directory, "MuPFChargeIso",  "Isolation #Delta(R)=0.4: PFCharge",   config.iso);
+  hMuPFNeutralIso = book1D(directory, "MuPFNeutralIso", "Isolation #Delta(R)=0.4: PFNeutral",  config.iso);
+  hMuPFPhotonIso  = book1D(directory, "MuPFPhotonIso",  "Isolation #Delta(R)=0.4: PFPhoton",   config.iso);
+  hMuPFPUIso      = book1D(directory, "MuPFPUIso",      "Isolation #Delta(R)=0.4: PFPU",       config.iso);
+  hMuPFIso        = book1D(directory, "MuPFIso",        "Isolation #Delta(R)=0.4: SumPt",      config.iso);
+  hMuPFIso_R      = book2D(directory, "MuPFIso_R",      "Isolation #Delta(R)=0.4: SumPt vs R", config.isoVr, config.isoSumPt);
+
+  if (config.genIsoDeltaR > 0) {
+
+    const TString cone = Form("Gen isolation #Delta(R)=%g", config.genIsoDeltaR);
+
+    hGenMuonIso           = book1D(directory, "GenMuonIso",           cone + ": SumPt",                     config.iso);
+    hGenMuonChargeIso     = book1D(directory, "GenMuonChargeIso",     cone + ": charged",                   config.iso);
+    hGenMuonNeutralIso    = book1D(directory, "GenMuonNeutralIso",    cone + ": neutral",                   config.iso);
+    hGenMuonIso_R         = book2D(directory, "GenMuonIso_R",         cone + ": SumPt vs R",                config.isoVr, config.isoSumPt);
+    hGenMuonNearestDR     = book1D(directory, "GenMuonNearestDR",     cone + ": dR of the closest particle", config.genNearestDR);
+    hGenMuonConeParticles = book1D(directory, "GenMuonConeParticles", cone + ": particles in the cone",      config.multiplicity);
+    hMuPFIso_GenIso       = book2D(directory, "MuPFIso_GenIso",       "Isolation #Delta(R)=0.4: SumPt vs gen SumPt", config.isoSumPt, config.isoSumPt);
+  }
+
+  hMuDxySig     = book1D(directory, "MuDxySig",     "ID-matched muon |dxy|/#sigma",         config.ipSig);
+  hMuDzSig      = book1D(directory, "MuDzSig",      "ID-matched muon |dz|/#sigma",          config.ipSig);
+  hMuDxy_GenDxy = book2D(directory, "MuDxy_GenDxy", "ID-matched muon |dxy| vs gen |dxy|", config.dxy, config.dxy);
+}
+
+
+template <class Flavour, class Directory>
+void MuonHistograms::bookFlavour(Directory& directory, const MuonAnalyzerConfig& config)
+{
+  const TString name  = TString(Flavour::name())      + "Muons_";
+  const TString noGen = TString(Flavour::noGenName()) + "Muons_noGen_";
+  const TString label = Flavour::label();
+
+  FlavourHistograms& fh = flavours[Flavour::flavour];
+
+  fh.eta = book1D(directory, name + "eta", label + "-gen dR-matched eta",   config.eta, true);
+  fh.phi = book1D(directory, name + "phi", label + " muons phi",            config.phi);
+  fh.dR  = book1D(directory, name + "dR",  label + "-gen dR",               config.dR);
+  fh.pt  = book1D(directory, name + "pt",  label + "-gen dR-matched pt",    config.pt,  true);
+  fh.vr  = book1D(directory, name + "vr",  label + "-gen dR-matched vr",    config.vr,  true);
+  fh.dxy = book1D(directory, name + "dxy", label + "-gen dR-matched |dxy|", config.dxy, true);
+  fh.lxy = book1D(directory, name + "lxy", label + "-gen dR-matched Lxy",   config.lxy, true);
+
+  fh.noGen_eta = book1D(directory, noGen + "eta", label + "-gen NO dR-matched eta",   config.eta, true);
+  fh.noGen_vr  = book1D(directory, noGen + "vr",  label + "-gen NO dR-matched vr",    config.vr,  true);
+  fh.noGen_pt  = book1D(directory, noGen + "pt",  label + "-gen NO dR-matched pt",    config.pt,  true);
+  fh.noGen_dxy = book1D(directory, noGen + "dxy", label + "-gen NO dR-matched |dxy|", config.dxy, true);
+  fh.noGen_lxy = book1D(directory, noGen + "lxy", label + "-gen NO dR-matched Lxy",   config.lxy, true);
+
+  if (!Flavour::hasResolution) return;
+
+  for (Int_t i=0; i<config.nPtBins(); i++)
+    fh.res.push_back(book1D(directory, name + Form("res_%d", i), "#Deltaq/p_{T} / q/p_{T}", Flavour::resAxis(config)));
+
+  // TH2 histograms
+  const TString gen = TString("Gen") + Flavour::name() + "Muons_";
+
+  fh.genEta = book2D(directory, gen + "eta", label + "-gen dR-matched eta", config.eta2D, config.eta2D);
+  fh.genPhi = book2D(directory, gen + "phi", label + "-gen dR-matched phi", config.phi2D, config.phi2D);
+}
+
+
+template <class Flavour, class Directory>
+void MuonHistograms::bookTagProbe(Directory& directory, const MuonAnalyzerConfig& config)
+{
+  const TString name  = TString("TnP_") + Flavour::name() + "Muons_";
+  const TString label = Flavour::label();
+
+  TagProbeHistograms& th = tagProbe[Flavour::flavour];
+
+  th.pass_pt  = book2D(directory, name + "pass_pt",  label + " passing probes, mass vs pt",     config.pt,  config.mass);
+  th.pass_eta = book2D(directory, name + "pass_eta", label + " passing probes, mass vs eta",    config.eta, config.mass);
+  th.pass_vr  = book2D(directory, name + "pass_vr",  label + " passing probes, mass vs |dxy|", config.vr,  config.mass);
+
+  th.fail_pt  = book2D(directory, name + "fail_pt",  label + " failing probes, mass vs pt",     config.pt,  config.mass);
+  th.fail_eta = book2D(directory, name + "fail_eta", label + " failing probes, mass vs eta",    config.eta, config.mass);
+  th.fail_vr  = book2D(directory, name + "fail_vr",  label + " failing probes, mass vs |dxy|", config.vr,  config.mass);
+}
+
+
+template <class Flavour>
+void MuonHistograms::fill(const MuonMatch& match, const GenMuon& gen, const MuonAnalyzerConfig& config)
+{
+  if (!match.found()) return;
+
+  FlavourHistograms& fh = flavours[Flavour::flavour];
+
+  const bool matched = match.deltaR < config.maxDeltaR;
+
+  fh.dR ->Fill(match.deltaR);
+  fh.phi->Fill(match.phi);
+
+  if (matched)
+    {
+      fh.eta->Fill(match.eta);
+      fh.pt ->Fill(match.pt);
+      fh.vr ->Fill(gen.vr);
+      fh.dxy->Fill(std::fabs(gen.dxy));
+      fh.lxy->Fill(gen.lxy);
+    } else {
+
+    fh.noGen_eta->Fill(match.eta);
+    fh.noGen_pt ->Fill(match.pt);
+    fh.noGen_vr ->Fill(gen.vr);
+    fh.noGen_dxy->Fill(std::fabs(gen.dxy));
+    fh.noGen_lxy->Fill(gen.lxy);
+  }
+
+  if (!matched || !Flavour::hasResolution) return;
+
+  fh.genEta->Fill(gen.eta, match.eta);
+  fh.genPhi->Fill(gen.phi, match.phi);
+
+  Float_t res = ((match.charge/match.pt) - (gen.charge/gen.pt)) / (gen.charge/gen.pt);
+
+  if (gen.ptBin >= 0) fh.res[gen.ptBin]->Fill(res);
+}
+
+template <class Flavour>
+void MuonHistograms::fillTagProbe(const MuonMatch&          match,
+				  Float_t                   mass,
+				  Float_t                   probePt,
+				  Float_t                   probeEta,
+				  Float_t                   probeDxy,
+				  const MuonAnalyzerConfig& config)
+{
+  TagProbeHistograms& th = tagProbe[Flavour::flavour];
+
+  if (match.found() && match.deltaR < config.maxDeltaR)
+    {
+      th.pass_pt ->Fill(probePt,  mass);
+      th.pass_eta->Fill(probeEta, mass);
+      th.pass_vr ->Fill(probeDxy, mass);
+    } else {
+
+    th.fail_pt ->Fill(probePt,  mass);
+    th.fail_eta->Fill(probeEta, mass);
+    th.fail_vr ->Fill(probeDxy, mass);
+  }
+}
+
+#endif
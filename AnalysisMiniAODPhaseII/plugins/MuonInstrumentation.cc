@@ -0,0 +1,106 @@
+#include "MuonInstrumentation.h"
+
+#include "TString.h"
+#include "TTree.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <string>
+
+
+void MuonPerformance::add(const MuonPerformance& other)
+{
+  events     += other.events;
+  genMuons   += other.genMuons;
+  recoMuons  += other.recoMuons;
+  candidates += other.candidates;
+  deltaR     += other.deltaR;
+
+  scratchGrowths  += other.scratchGrowths;
+  peakScratchBytes = std::max(peakScratchBytes, other.peakScratchBytes);
+  histogramBytes   = std::max(histogramBytes,   other.histogramBytes);
+
+  skippedEvents   += other.skippedEvents;
+  productsRead    += other.productsRead;
+  productsSkipped += other.productsSkipped;
+
+  for (Int_t s=0; s<nMuonStages; s++) seconds[s] += other.seconds[s];
+}
+
+
+void fillPerformanceTree(TTree* tree, const std::vector<MuonPerformance>& streams, Double_t wallSeconds)
+{
+  Int_t           stream;
+  MuonPerformance p;
+
+  tree->Branch("stream",     &stream,       "stream/I");
+  tree->Branch("events",     &p.events,     "events/l");
+  tree->Branch("genMuons",   &p.genMuons,   "genMuons/l");
+  tree->Branch("recoMuons",  &p.recoMuons,  "recoMuons/l");
+  tree->Branch("candidates", &p.candidates, "candidates/l");
+  tree->Branch("deltaR",     &p.deltaR,     "deltaR/l");
+
+  tree->Branch("scratchGrowths",   &p.scratchGrowths,   "scratchGrowths/l");
+  tree->Branch("peakScratchBytes", &p.peakScratchBytes, "peakScratchBytes/l");
+  tree->Branch("histogramBytes",   &p.histogramBytes,   "histogramBytes/l");
+
+  tree->Branch("skippedEvents",   &p.skippedEvents,   "skippedEvents/l");
+  tree->Branch("productsRead",    &p.productsRead,    "productsRead/l");
+  tree->Branch("productsSkipped", &p.productsSkipped, "productsSkipped/l");
+
+  for (Int_t s=0; s<nMuonStages; s++) {
+
+    TString name = TString("time_") + muonStageNames[s];
+
+    tree->Branch(name.Data(), &p.seconds[s], (name + "/D").Data());
+  }
+
+  tree->Branch("wallTime", &wallSeconds, "wallTime/D");
+
+  for (stream=0; stream<Int_t(streams.size()); stream++) {
+    p = streams[stream];
+    tree->Fill();
+  }
+
+  tree->ResetBranchAddresses();
+}
+
+
+void printPerformance(std::ostream& out, const std::vector<MuonPerformance>& streams, Double_t wallSeconds)
+{
+  MuonPerformance total;
+
+  for (const auto& p : streams) total.add(p);
+
+  const Double_t seconds = total.totalSeconds();
+  const Double_t events  = (total.events > 0) ? total.events : 1;
+
+  out << "\n [ExampleMuonAnalyzer] " << total.events << " events in " << streams.size() << " streams\n"
+      << "   gen muons per event        " << total.genMuons   / events << "\n"
+      << "   reco muons per event       " << total.recoMuons  / events << "\n"
+      << "   candidates per event       " << total.candidates / events << "\n"
+      << "   dR evaluations per event   " << total.deltaR     / events << "\n"
+      << "   scratch growths            " << total.scratchGrowths << " events (buffers reused in the others)\n"
+      << "   peak scratch per stream    " << total.peakScratchBytes / 1024. << " kB\n"
+      << "   histograms per stream      " << total.histogramBytes / 1024. << " kB\n"
+      << "   events skipped by gen scan " << total.skippedEvents << " (" << std::fixed << std::setprecision(1) << 100 * total.skippedEvents / events << "%)\n"
+      << "   products skipped           " << total.productsSkipped << " of " << total.productsRead + total.productsSkipped
+      << " (" << 100. * total.productsSkipped / std::max<ULong64_t>(total.productsRead + total.productsSkipped, 1) << "%)"
+      << std::defaultfloat << std::setprecision(6) << "\n";
+
+  for (Int_t s=0; s<nMuonStages; s++)
+    out << "   " << std::left << std::setw(27) << (std::string(muonStageNames[s]) + " [us/event]") << std::right
+	<< 1e6 * total.seconds[s] / events
+	<< "  (" << std::fixed << std::setprecision(1) << ((seconds > 0) ? 100 * total.seconds[s] / seconds : 0) << "%)"
+	<< std::defaultfloat << std::setprecision(6) << "\n";
+
+  if (seconds > 0)
+    out << "   analyzer throughput        " << total.events / seconds << " events/s, "
+	<< total.candidates / seconds << " candidates/s (time in analyze, summed over streams)\n";
+
+  if (wallSeconds > 0)
+    out << "   job throughput             " << total.events / wallSeconds << " events/s ("
+	<< wallSeconds << " s wall time)\n";
+
+  out << std::endl;
+}
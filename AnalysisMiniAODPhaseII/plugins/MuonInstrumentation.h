@@ -0,0 +1,99 @@
+#ifndef MuonInstrumentation_H
+#define MuonInstrumentation_H
+
+#include "Rtypes.h"
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+
+class TTree;
+
+
+// Stages of ExampleMuonAnalyzer::analyze()
+enum MuonStage {
+  kFetchStage,   // getByToken of the input collections, except the probes
+  kVertexStage,  // primary vertex search
+  kTableStage,   // reco muon ID and isolation
+  kMatchStage,   // candidate extraction and gen-to-reco matching
+  kGenIsoStage,  // packed gen particle grid and gen isolation
+  kTnPStage,     // tag-probe pairs and probe matching
+  kFillStage,    // gen pre-scan, histograms and ntuple
+  nMuonStages
+};
+
+const char* const muonStageNames[nMuonStages] = {"fetch", "vertex", "table", "match", "genIso", "tnp", "fill"};
+
+
+//------------------------------------------------------------------------------
+// StageClock
+//
+// Wall-clock time between successive lap() calls, in seconds
+//------------------------------------------------------------------------------
+class StageClock {
+ public:
+  StageClock() : last(std::chrono::steady_clock::now()) {}
+
+  void start() { last = std::chrono::steady_clock::now(); }
+
+  Double_t lap()
+  {
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    const Double_t seconds = std::chrono::duration<Double_t>(now - last).count();
+
+    last = now;
+
+    return seconds;
+  }
+
+ private:
+  std::chrono::steady_clock::time_point last;
+};
+
+
+//------------------------------------------------------------------------------
+// MuonPerformance
+//
+// Event counters and time per stage of a stream, summed in the global cache
+//------------------------------------------------------------------------------
+struct MuonPerformance {
+  ULong64_t events;
+  ULong64_t genMuons;
+  ULong64_t recoMuons;
+  ULong64_t candidates;
+  ULong64_t deltaR;
+  ULong64_t scratchGrowths;
+  ULong64_t peakScratchBytes;
+  ULong64_t histogramBytes;
+  ULong64_t skippedEvents;
+  ULong64_t productsRead;
+  ULong64_t productsSkipped;
+  Double_t  seconds[nMuonStages];
+
+  MuonPerformance() : events(0), genMuons(0), recoMuons(0), candidates(0), deltaR(0), scratchGrowths(0), peakScratchBytes(0), histogramBytes(0),
+    skippedEvents(0), productsRead(0), productsSkipped(0)
+  {
+    for (Int_t s=0; s<nMuonStages; s++) seconds[s] = 0;
+  }
+
+  Double_t totalSeconds() const
+  {
+    Double_t total = 0;
+
+    for (Int_t s=0; s<nMuonStages; s++) total += seconds[s];
+
+    return total;
+  }
+
+  void add(const MuonPerformance& other);
+};
+
+
+// One entry per stream, plus the job wall time
+void fillPerformanceTree(TTree* tree, const std::vector<MuonPerformance>& streams, Double_t wallSeconds);
+
+void printPerformance(std::ostream& out, const std::vector<MuonPerformance>& streams, Double_t wallSeconds);
+
+#endif
@@ -0,0 +1,231 @@
+#include "MuonMatcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+
+constexpr float MuonMatcher::kPi;
+constexpr float MuonMatcher::kTwoPi;
+
+
+MuonMatcher::MuonMatcher(float maxDeltaR, float maxEta) :
+  maxEta(maxEta)
+{
+  nEtaCells = std::max(1, int(2 * maxEta / maxDeltaR));
+  nPhiCells = std::max(1, int(kTwoPi / maxDeltaR));
+
+  etaCellWidth = 2 * maxEta / nEtaCells;
+  phiCellWidth = kTwoPi / nPhiCells;
+
+  clear();
+}
+
+
+void MuonMatcher::clear()
+{
+  candEta    .clear();
+  candPhi    .clear();
+  candPt     .clear();
+  candCharge .clear();
+  candMuon   .clear();
+  candFlavour.clear();
+  candCell   .clear();
+
+  for (int f=0; f<nMuonFlavours; f++) nFlavourCands[f] = 0;
+
+  nDeltaR = 0;
+}
+
+
+void MuonMatcher::add(MuonFlavour flavour,
+		      int         muon,
+		      float       eta,
+		      float       phi,
+		      float       pt,
+		      float       charge)
+{
+  candEta    .push_back(eta);
+  candPhi    .push_back(phi);
+  candPt     .push_back(pt);
+  candCharge .push_back(charge);
+  candMuon   .push_back(muon);
+  candFlavour.push_back(flavour);
+  candCell   .push_back(etaCell(eta) * nPhiCells + phiCell(phi));
+
+  nFlavourCands[flavour]++;
+}
+
+
+void MuonMatcher::build()
+{
+  const int nCells = nEtaCells * nPhiCells;
+
+  // Counting sort of the candidates by cell, keeping the insertion order
+  // inside each cell
+  cellStart.assign(nCells + 1, 0);
+
+  for (int cell : candCell) cellStart[cell + 1]++;
+
+  for (int c=0; c<nCells; c++) cellStart[c + 1] += cellStart[c];
+
+  sorted.resize(candCell.size());
+
+  for (unsigned i=0; i<candCell.size(); i++) sorted[cellStart[candCell[i]]++] = i;
+
+  for (int c=nCells; c>0; c--) cellStart[c] = cellStart[c - 1];
+
+  cellStart[0] = 0;
+}
+
+
+std::size_t MuonMatcher::scratchBytes() const
+{
+  return sizeof(float) * (candEta.capacity() + candPhi.capacity() + candPt.capacity() + candCharge.capacity())
+    + sizeof(int) * (candMuon.capacity() + candCell.capacity() + cellStart.capacity() + sorted.capacity())
+    + candFlavour.capacity();
+}
+
+
+void MuonMatcher::match(float eta, float phi, MuonMatch (&matches)[nMuonFlavours])
+{
+  float best2   [nMuonFlavours];
+  int   bestCand[nMuonFlavours];
+
+  for (int f=0; f<nMuonFlavours; f++) {
+    best2   [f] = std::numeric_limits<float>::max();
+    bestCand[f] = -1;
+  }
+
+  const int   ie0     = etaCell(eta);
+  const int   ip0     = phiCell(phi);
+  const float width   = std::min(etaCellWidth, phiCellWidth);
+  const int   maxRing = std::max(nEtaCells, nPhiCells / 2 + 1);
+
+  for (int r=0; r<=maxRing; r++) {
+
+    const int ieMin = std::max(0,             ie0 - r);
+    const int ieMax = std::min(nEtaCells - 1, ie0 + r);
+
+    for (int ie=ieMin; ie<=ieMax; ie++) {
+
+      const int die = std::abs(ie - ie0);
+
+      if (2*r + 1 < nPhiCells) {
+	if (die == r) {
+	  for (int dip=-r; dip<=r; dip++)
+	    visitCell(ie * nPhiCells + (ip0 + dip + nPhiCells) % nPhiCells, eta, phi, best2, bestCand);
+	} else {
+	  visitCell(ie * nPhiCells + (ip0 - r + nPhiCells) % nPhiCells, eta, phi, best2, bestCand);
+	  visitCell(ie * nPhiCells + (ip0 + r)             % nPhiCells, eta, phi, best2, bestCand);
+	}
+      } else {
+
+	// The ring wraps around in phi, visit each column once
+	for (int ip=0; ip<nPhiCells; ip++) {
+	  const int dip  = std::abs(ip - ip0);
+	  const int circ = std::min(dip, nPhiCells - dip);
+	  if (std::max(die, circ) == r) visitCell(ie * nPhiCells + ip, eta, phi, best2, bestCand);
+	}
+      }
+    }
+
+    // Every unvisited candidate is further than r cell widths away
+    const float bound2 = (r * width) * (r * width);
+
+    bool done = true;
+
+    for (int f=0; f<nMuonFlavours; f++)
+      if (nFlavourCands[f] > 0 && best2[f] > bound2) done = false;
+
+    if (done) break;
+  }
+
+  for (int f=0; f<nMuonFlavours; f++) {
+
+    MuonMatch& m = matches[f];
+
+    const int i = bestCand[f];
+
+    if (i < 0) {
+      m.muon   = -1;
+      m.deltaR = 999;
+      m.eta    = -999;
+      m.phi    = -999;
+      m.pt     = -999;
+      m.charge = -999;
+    } else {
+      m.muon   = candMuon[i];
+      m.deltaR = sqrt(best2[f]);
+      m.eta    = candEta[i];
+      m.phi    = candPhi[i];
+      m.pt     = candPt[i];
+      m.charge = candCharge[i];
+    }
+  }
+}
+
+
+MuonCandidate MuonMatcher::candidate(unsigned i) const
+{
+  MuonCandidate c;
+
+  c.muon    = candMuon[i];
+  c.flavour = MuonFlavour(candFlavour[i]);
+  c.eta     = candEta[i];
+  c.phi     = candPhi[i];
+  c.pt      = candPt[i];
+  c.charge  = candCharge[i];
+
+  return c;
+}
+
+
+void MuonMatcher::visitCell(int cell, float eta, float phi, float (&best2)[nMuonFlavours], int (&bestCand)[nMuonFlavours])
+{
+  for (int k=cellStart[cell]; k<cellStart[cell + 1]; k++) {
+
+    const int i = sorted[k];
+    const int f = candFlavour[i];
+
+    const float dEta = candEta[i] - eta;
+    const float dPhi = deltaPhi(candPhi[i], phi);
+    const float dR2  = dPhi*dPhi + dEta*dEta;
+
+    nDeltaR++;
+
+    // Ties go to the first candidate, as in a loop over the collection
+    if (dR2 < best2[f] || (dR2 == best2[f] && i < bestCand[f])) {
+      best2   [f] = dR2;
+      bestCand[f] = i;
+    }
+  }
+}
+
+
+int MuonMatcher::etaCell(float eta) const
+{
+  const int ie = int((eta + maxEta) / etaCellWidth);
+
+  return std::min(std::max(ie, 0), nEtaCells - 1);
+}
+
+
+int MuonMatcher::phiCell(float phi) const
+{
+  const int ip = int((deltaPhi(phi, 0) + kPi) / phiCellWidth);
+
+  return std::min(std::max(ip, 0), nPhiCells - 1);
+}
+
+
+float MuonMatcher::deltaPhi(float phi1, float phi2)
+{
+  float dPhi = phi1 - phi2;
+
+  while (dPhi >=  kPi) dPhi -= kTwoPi;
+  while (dPhi <  -kPi) dPhi += kTwoPi;
+
+  return dPhi;
+}
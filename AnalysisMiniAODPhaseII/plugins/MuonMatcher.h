@@ -0,0 +1,123 @@
+#ifndef MuonMatcher_H
+#define MuonMatcher_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+enum MuonFlavour {kTight, kSta, kTrk, kGlb, nMuonFlavours};
+
+const char* const muonFlavourNames[nMuonFlavours] = {"Tight", "Sta", "Trk", "Glb"};
+
+
+//------------------------------------------------------------------------------
+// MuonCandidate
+//
+// Track kinematics of one flavour of a reco muon.
+//------------------------------------------------------------------------------
+struct MuonCandidate {
+  int         muon;  // index in the muon collection
+  MuonFlavour flavour;
+  float       eta;
+  float       phi;
+  float       pt;
+  float       charge;
+};
+
+
+//------------------------------------------------------------------------------
+// MuonMatch
+//
+// Closest reco candidate of one flavour to a gen muon. deltaR stays at 999
+// when the event has no candidate of that flavour.
+//------------------------------------------------------------------------------
+struct MuonMatch {
+  int   muon;    // index in the muon collection, -1 if none
+  float deltaR;
+  float eta;
+  float phi;
+  float pt;
+  float charge;
+
+  bool found() const { return muon >= 0; }
+};
+
+
+//------------------------------------------------------------------------------
+// MuonMatcher
+//
+// Per-event gen-to-reco dR matcher. The reco candidates of all the flavours
+// are stored once per event as a structure of arrays and bucketed in an
+// eta-phi grid whose cells are at least maxDeltaR wide. A query walks rings of
+// cells around the gen muon and stops as soon as no unvisited cell can hold a
+// closer candidate, so it returns the same closest candidate per flavour as an
+// exhaustive loop, including those beyond maxDeltaR used for the noGen plots.
+//
+// Candidates must have |eta| <= maxEta. The buffers are kept between events.
+//------------------------------------------------------------------------------
+class MuonMatcher {
+ public:
+  MuonMatcher(float maxDeltaR, float maxEta = 2.4);
+
+  // Forget the candidates of the previous event
+  void clear();
+
+  void add(MuonFlavour flavour,
+	   int         muon,
+	   float       eta,
+	   float       phi,
+	   float       pt,
+	   float       charge);
+
+  // Bucket the candidates, must be called after the last add()
+  void build();
+
+  // Closest candidate of each flavour to (eta, phi)
+  void match(float eta, float phi, MuonMatch (&matches)[nMuonFlavours]);
+
+  // Candidates in the order they were added
+  MuonCandidate candidate(unsigned i) const;
+
+  unsigned size()           const { return candEta.size(); }
+  unsigned deltaRComputed() const { return nDeltaR; }
+
+  // Memory held by the buffers, kept between events
+  std::size_t scratchBytes() const;
+
+  // Signed difference in [-pi, pi)
+  static float deltaPhi(float phi1, float phi2);
+
+  static constexpr float kPi    = 3.14159265f;
+  static constexpr float kTwoPi = 6.28318531f;
+
+ private:
+  int  etaCell(float eta) const;
+  int  phiCell(float phi) const;
+  void visitCell(int cell, float eta, float phi, float (&best2)[nMuonFlavours], int (&bestCand)[nMuonFlavours]);
+
+  // Grid
+  float maxEta;
+  int   nEtaCells;
+  int   nPhiCells;
+  float etaCellWidth;
+  float phiCellWidth;
+
+  // Candidates, structure of arrays
+  std::vector<float>        candEta;
+  std::vector<float>        candPhi;
+  std::vector<float>        candPt;
+  std::vector<float>        candCharge;
+  std::vector<int>          candMuon;
+  std::vector<std::uint8_t> candFlavour;
+  std::vector<int>          candCell;
+
+  // Candidates sorted by cell, cellStart[c] to cellStart[c+1]
+  std::vector<int>          cellStart;
+  std::vector<int>          sorted;
+
+  unsigned nFlavourCands[nMuonFlavours];
+  unsigned nDeltaR;
+};
+
+#endif
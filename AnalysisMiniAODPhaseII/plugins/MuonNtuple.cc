@@ -0,0 +1,98 @@
+#include "MuonNtuple.h"
+
+#include "TString.h"
+#include "TTree.h"
+
+
+void MuonNtupleRow::reset()
+{
+  run   = 0;
+  lumi  = 0;
+  event = 0;
+  isGen = false;
+
+  gen_charge = -999;
+  gen_pt     = -999;
+  gen_eta    = -999;
+  gen_phi    = -999;
+  gen_vx     = -999;
+  gen_vy     = -999;
+  gen_vz     = -999;
+  gen_vr     = -999;
+  gen_dxy    = -999;
+  gen_dz     = -999;
+  gen_lxy    = -999;
+
+  iso = -999;
+
+  gen_iso       = -999;
+  gen_chargeIso = -999;
+  gen_nearestDR =  999;
+
+  for (Int_t f=0; f<nMuonFlavours; f++) {
+    dR    [f] =  999;
+    pt    [f] = -999;
+    eta   [f] = -999;
+    phi   [f] = -999;
+    charge[f] = -999;
+    res   [f] = -999;
+    id    [f] =    0;
+  }
+}
+
+
+MuonNtuple::MuonNtuple() : tree(nullptr)
+{
+  row.reset();
+}
+
+
+void MuonNtuple::book(TTree* t)
+{
+  tree = t;
+
+  tree->Branch("run",   &row.run,   "run/i");
+  tree->Branch("lumi",  &row.lumi,  "lumi/i");
+  tree->Branch("event", &row.event, "event/l");
+  tree->Branch("isGen", &row.isGen, "isGen/O");
+
+  tree->Branch("gen_charge", &row.gen_charge, "gen_charge/F");
+  tree->Branch("gen_pt",     &row.gen_pt,     "gen_pt/F");
+  tree->Branch("gen_eta",    &row.gen_eta,    "gen_eta/F");
+  tree->Branch("gen_phi",    &row.gen_phi,    "gen_phi/F");
+  tree->Branch("gen_vx",     &row.gen_vx,     "gen_vx/F");
+  tree->Branch("gen_vy",     &row.gen_vy,     "gen_vy/F");
+  tree->Branch("gen_vz",     &row.gen_vz,     "gen_vz/F");
+  tree->Branch("gen_vr",     &row.gen_vr,     "gen_vr/F");
+  tree->Branch("gen_dxy",    &row.gen_dxy,    "gen_dxy/F");
+  tree->Branch("gen_dz",     &row.gen_dz,     "gen_dz/F");
+  tree->Branch("gen_lxy",    &row.gen_lxy,    "gen_lxy/F");
+
+  tree->Branch("iso", &row.iso, "iso/F");
+
+  tree->Branch("gen_iso",       &row.gen_iso,       "gen_iso/F");
+  tree->Branch("gen_chargeIso", &row.gen_chargeIso, "gen_chargeIso/F");
+  tree->Branch("gen_nearestDR", &row.gen_nearestDR, "gen_nearestDR/F");
+
+  for (Int_t f=0; f<nMuonFlavours; f++) {
+
+    TString name = muonFlavourNames[f];
+
+    tree->Branch((name + "_dR").Data(),     &row.dR    [f], (name + "_dR/F").Data());
+    tree->Branch((name + "_pt").Data(),     &row.pt    [f], (name + "_pt/F").Data());
+    tree->Branch((name + "_eta").Data(),    &row.eta   [f], (name + "_eta/F").Data());
+    tree->Branch((name + "_phi").Data(),    &row.phi   [f], (name + "_phi/F").Data());
+    tree->Branch((name + "_charge").Data(), &row.charge[f], (name + "_charge/F").Data());
+    tree->Branch((name + "_res").Data(),    &row.res   [f], (name + "_res/F").Data());
+    tree->Branch((name + "_id").Data(),     &row.id    [f], (name + "_id/b").Data());
+  }
+}
+
+
+void MuonNtuple::fill(const std::vector<MuonNtupleRow>& rows)
+{
+  for (const auto& r : rows) {
+    row = r;
+    tree->Fill();
+  }
+}
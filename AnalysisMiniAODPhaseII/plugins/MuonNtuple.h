@@ -0,0 +1,80 @@
+#ifndef MuonNtuple_H
+#define MuonNtuple_H
+
+#include "MuonMatcher.h"
+
+#include "Rtypes.h"
+
+#include <vector>
+
+
+class TTree;
+
+
+//------------------------------------------------------------------------------
+// MuonNtupleRow
+//
+// One row per gen muon in acceptance (isGen = 1), with the closest reco muon
+// of each flavour whatever its distance, and one row per reco muon that is
+// not dR-matched to any gen muon (isGen = 0), with its own kinematics. Unset
+// values are -999, and dR is 999 when there is no match.
+//------------------------------------------------------------------------------
+struct MuonNtupleRow {
+  UInt_t    run;
+  UInt_t    lumi;
+  ULong64_t event;
+  Bool_t    isGen;
+
+  Float_t   gen_charge;
+  Float_t   gen_pt;
+  Float_t   gen_eta;
+  Float_t   gen_phi;
+  Float_t   gen_vx;
+  Float_t   gen_vy;
+  Float_t   gen_vz;
+  Float_t   gen_vr;
+  Float_t   gen_dxy;  // against the selected primary vertex
+  Float_t   gen_dz;
+  Float_t   gen_lxy;
+
+  Float_t   iso;  // of the reco muon, or of the tight match for gen rows
+
+  Float_t   gen_iso;          // gen isolation of the gen muon, relative to its pt
+  Float_t   gen_chargeIso;
+  Float_t   gen_nearestDR;    // closest packed gen particle in the cone
+
+  Float_t   dR    [nMuonFlavours];
+  Float_t   pt    [nMuonFlavours];
+  Float_t   eta   [nMuonFlavours];
+  Float_t   phi   [nMuonFlavours];
+  Float_t   charge[nMuonFlavours];
+  Float_t   res   [nMuonFlavours];  // (q/pt reco - q/pt gen) / (q/pt gen)
+  UChar_t   id    [nMuonFlavours];  // MuonIdBit of the reco muon
+
+  void reset();
+};
+
+
+//------------------------------------------------------------------------------
+// MuonNtuple
+//
+// Flat TTree with one scalar branch per column, e.g. gen_vr or Sta_dR.
+// Streams buffer their rows and hand them over in batches.
+//------------------------------------------------------------------------------
+class MuonNtuple {
+ public:
+  MuonNtuple();
+
+  void book(TTree* tree);
+
+  bool booked() const { return tree != nullptr; }
+
+  // Not thread safe, the caller serializes the streams
+  void fill(const std::vector<MuonNtupleRow>& rows);
+
+ private:
+  TTree*        tree;
+  MuonNtupleRow row;
+};
+
+#endif
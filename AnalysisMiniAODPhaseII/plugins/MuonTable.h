@@ -0,0 +1,72 @@
+#ifndef MuonTable_H
+#define MuonTable_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+enum MuonIdBit {
+  kIsTight      = 1 << 0,
+  kIsSoft       = 1 << 1,
+  kIsMedium     = 1 << 2,
+  kIsStandAlone = 1 << 3,
+  kIsTracker    = 1 << 4,
+  kIsGlobal     = 1 << 5
+};
+
+
+//------------------------------------------------------------------------------
+// MuonTable
+//
+// Per-event properties of the reco muons, evaluated once per muon before the
+// gen loop. Row j belongs to muon j of the collection. The relative PF
+// isolation components are the R = 0.4 sums divided by the muon pt.
+//------------------------------------------------------------------------------
+struct MuonTable {
+
+  std::vector<float>        chargeIso;
+  std::vector<float>        neutralIso;
+  std::vector<float>        photonIso;
+  std::vector<float>        puIso;
+  std::vector<float>        iso;  // delta-beta corrected
+  std::vector<std::uint8_t> idBits;
+
+  unsigned size() const { return idBits.size(); }
+
+  bool has(unsigned j, MuonIdBit bit) const { return idBits[j] & bit; }
+
+  // Memory held by the buffers, kept between events
+  std::size_t scratchBytes() const
+  {
+    return sizeof(float) * (chargeIso.capacity() + neutralIso.capacity() + photonIso.capacity() + puIso.capacity() + iso.capacity())
+      + idBits.capacity();
+  }
+
+  void clear()
+  {
+    chargeIso .clear();
+    neutralIso.clear();
+    photonIso .clear();
+    puIso     .clear();
+    iso       .clear();
+    idBits    .clear();
+  }
+
+  void push_back(float        charge,
+		 float        neutral,
+		 float        photon,
+		 float        pu,
+		 float        combined,
+		 std::uint8_t bits)
+  {
+    chargeIso .push_back(charge);
+    neutralIso.push_back(neutral);
+    photonIso .push_back(photon);
+    puIso     .push_back(pu);
+    iso       .push_back(combined);
+    idBits    .push_back(bits);
+  }
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "MuonTagAndProbe.h"
+#include "MuonMatcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+  // The bounds are loosened by this much, so that float rounding cannot
+  // reject a pair inside the window
+  const float kBoundMargin = 1e-3f;
+}
+
+
+MuonTagAndProbe::MuonTagAndProbe(float minMass, float maxMass, float maxEta) :
+  minMass2(minMass * minMass),
+  maxMass2(maxMass * maxMass),
+  maxEta  (maxEta)
+{
+  clear();
+}
+
+
+void MuonTagAndProbe::clear()
+{
+  tagIndex     .clear();
+  tagEta       .clear();
+  tagPhi       .clear();
+  tagPt        .clear();
+  tagCharge    .clear();
+  tagMinProbePt.clear();
+
+  minProbePt = std::numeric_limits<float>::max();
+
+  nKept = 0;
+
+  pairs.clear();
+
+  nProbesAdded = 0;
+  nMass        = 0;
+}
+
+
+void MuonTagAndProbe::addTag(int tag, float eta, float phi, float pt, float charge)
+{
+  tagIndex .push_back(tag);
+  tagEta   .push_back(eta);
+  tagPhi   .push_back(phi);
+  tagPt    .push_back(pt);
+  tagCharge.push_back(charge);
+
+  // Softest probe that can reach minMass with this tag
+  const float softest = (1 - kBoundMargin) * minMass2 / (2 * pt * (std::cosh(std::fabs(eta) + maxEta) + 1));
+
+  tagMinProbePt.push_back(softest);
+
+  minProbePt = std::min(minProbePt, softest);
+}
+
+
+// Like in GenParticleGrid::add(), the probe is always written and only
+// counted when kept
+void MuonTagAndProbe::addProbe(int probe, float eta, float phi, float pt, float charge)
+{
+  if (nKept == probeIndex.size()) {
+    const unsigned n = std::max(64u, 2 * nKept);
+    probeIndex .resize(n);
+    probeEta   .resize(n);
+    probePhi   .resize(n);
+    probePt    .resize(n);
+    probeCharge.resize(n);
+  }
+
+  probeIndex [nKept] = probe;
+  probeEta   [nKept] = eta;
+  probePhi   [nKept] = phi;
+  probePt    [nKept] = pt;
+  probeCharge[nKept] = charge;
+
+  nProbesAdded++;
+  nKept += (pt >= minProbePt);
+}
+
+
+void MuonTagAndProbe::build()
+{
+  const unsigned n = nKept;
+
+  if (n == 0) return;
+
+  const float softestProbe = *std::min_element(probePt.begin(), probePt.begin() + n);
+
+  selected.resize(n);
+
+  for (unsigned t=0; t<tagIndex.size(); t++) {
+
+    // Largest deta of a pair lighter than maxMass
+    const float maxDEta = (1 + kBoundMargin) * std::acosh(1 + maxMass2 / (2 * tagPt[t] * softestProbe));
+
+    // Probes passing the bounds, without a mispredicted branch for each of
+    // the mostly random outcomes
+    unsigned nSelected = 0;
+
+    for (unsigned k=0; k<n; k++) {
+
+      selected[nSelected] = k;
+
+      nSelected += (probeCharge[k] != tagCharge[t]) & (probePt[k] >= tagMinProbePt[t]) & (std::fabs(probeEta[k] - tagEta[t]) <= maxDEta);
+    }
+
+    for (unsigned s=0; s<nSelected; s++) {
+
+      const unsigned k = selected[s];
+
+      const float scale = 2 * tagPt[t] * probePt[k];
+      const float mass2 = scale * (std::cosh(probeEta[k] - tagEta[t]) - std::cos(MuonMatcher::deltaPhi(probePhi[k], tagPhi[t])));
+
+      nMass++;
+
+      if (mass2 < minMass2 || mass2 > maxMass2) continue;
+
+      pairs.push_back(TagProbePair{tagIndex[t], probeIndex[k], std::sqrt(mass2)});
+    }
+  }
+}
+
+
+std::size_t MuonTagAndProbe::scratchBytes() const
+{
+  return sizeof(float) * (tagEta.capacity() + tagPhi.capacity() + tagPt.capacity() + tagCharge.capacity() + tagMinProbePt.capacity() +
+			  probeEta.capacity() + probePhi.capacity() + probePt.capacity() + probeCharge.capacity())
+    + sizeof(int) * (tagIndex.capacity() + probeIndex.capacity() + selected.capacity())
+    + sizeof(TagProbePair) * pairs.capacity();
+}
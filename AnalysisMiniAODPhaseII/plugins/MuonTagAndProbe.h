@@ -0,0 +1,101 @@
+#ifndef MuonTagAndProbe_H
+#define MuonTagAndProbe_H
+
+#include <cstddef>
+#include <vector>
+
+
+//------------------------------------------------------------------------------
+// TagProbePair
+//
+// A tag and a probe of opposite charge with a mass inside the window. tag and
+// probe are the indices given to addTag() and addProbe().
+//------------------------------------------------------------------------------
+struct TagProbePair {
+  int   tag;
+  int   probe;
+  float mass;  // [GeV]
+};
+
+
+//------------------------------------------------------------------------------
+// MuonTagAndProbe
+//
+// Per-event tag-probe pair builder. The masses of massless tracks
+//
+//   m^2 = 2 pt_tag pt_probe (cosh(deta) - cos(dphi))
+//
+// are bounded without any cosh or cos, from the pt and eta alone:
+//
+//  - within the eta acceptance m^2 <= 2 pt_tag pt_probe (cosh(|eta_tag| + maxEta) + 1),
+//    so each tag has a softest probe that can reach minMass. The probes below
+//    the lowest of these are rejected as they are added, which removes most
+//    of the soft tracks that dominate the probes at high pileup.
+//  - m^2 >= 2 pt_tag pt_probe (cosh(deta) - 1), so with the softest kept
+//    probe each tag has a largest deta that can stay below maxMass. For a
+//    J/psi window it is a narrow slice of the acceptance.
+//
+// Only the pairs passing both, and of opposite charge, get their mass
+// computed. The result is the same as a loop over all the tag x probe pairs.
+//
+// All the tags must be added before the first probe. Tags and probes must
+// have |eta| <= maxEta. The buffers are kept between events.
+//------------------------------------------------------------------------------
+class MuonTagAndProbe {
+ public:
+  MuonTagAndProbe(float minMass, float maxMass, float maxEta);
+
+  // Forget the tags, probes and pairs of the previous event
+  void clear();
+
+  void addTag(int tag, float eta, float phi, float pt, float charge);
+
+  void addProbe(int probe, float eta, float phi, float pt, float charge);
+
+  // Pair the probes with the tags, must be called after the last addProbe()
+  void build();
+
+  unsigned            nTags()          const { return tagIndex.size(); }
+  unsigned            nPairs()         const { return pairs.size(); }
+  const TagProbePair& pair(unsigned i) const { return pairs[i]; }
+  unsigned            nProbes()        const { return nProbesAdded; }
+  unsigned            nProbesKept()    const { return nKept; }
+  unsigned            massComputed()   const { return nMass; }
+
+  // Memory held by the buffers, kept between events
+  std::size_t scratchBytes() const;
+
+ private:
+  float minMass2;
+  float maxMass2;
+  float maxEta;
+
+  // Tags, in the order they were added, with the softest probe they can pair
+  std::vector<int>   tagIndex;
+  std::vector<float> tagEta;
+  std::vector<float> tagPhi;
+  std::vector<float> tagPt;
+  std::vector<float> tagCharge;
+  std::vector<float> tagMinProbePt;
+
+  float minProbePt;  // of all the tags
+
+  // Kept probes in the order they were added, the first nKept of the
+  // buffers
+  unsigned           nKept;
+  std::vector<int>   probeIndex;
+  std::vector<float> probeEta;
+  std::vector<float> probePhi;
+  std::vector<float> probePt;
+  std::vector<float> probeCharge;
+
+  // Probes of the current tag passing the bounds
+  std::vector<unsigned> selected;
+
+  std::vector<TagProbePair> pairs;
+
+  unsigned nProbesAdded;
+  unsigned nMass;
+};
+
+#endif
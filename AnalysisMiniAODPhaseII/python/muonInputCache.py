@@ -0,0 +1,157 @@
+# Local MINIAOD cache of the collections read by ExampleMuonAnalyzer
+#
+# Cached files are reduced copies of the input files, keeping only the
+# analysisProducts, stored under the cache directory with their /store/...
+# path. Their modification time is refreshed on every use and the least
+# recently used files are evicted once the cache is over its size limit.
+# A local directory holding a /store/... tree can stand in for the xrootd
+# redirector.
+
+from __future__ import print_function
+
+import os
+import shutil
+import subprocess
+import threading
+
+try:
+    import Queue as queue
+except ImportError:
+    import queue
+
+
+analysisProducts = ['slimmedMuons',
+                    'prunedGenParticles',
+                    'offlineSlimmedPrimaryVertices',
+                    'offlineBeamSpot']
+
+
+def keepCommands(extraProducts=()):
+    """Keep the analysisProducts, and extraProducts such as the tag-and-probe or gen isolation ones"""
+    return ['drop *'] + ['keep *_%s_*_*' % product for product in analysisProducts + list(extraProducts)]
+
+
+def logicalFileName(url):
+    """/store/... part of a file: or root:// url, or its base name"""
+    i = url.find('/store/')
+    return url[i:] if i >= 0 else '/' + os.path.basename(url)
+
+
+def sourceUrl(url, redirectorDir=''):
+    """Where to read url from, a local /store/... tree replacing the redirector"""
+    if redirectorDir and url.startswith('root://'):
+        return 'file:' + os.path.join(os.path.abspath(redirectorDir), logicalFileName(url).lstrip('/'))
+    return url
+
+
+class InputCache(object):
+
+    def __init__(self, cacheDir, maxBytes=50 * 1024**3):
+        self.cacheDir = os.path.abspath(cacheDir)
+        self.maxBytes = maxBytes
+        self.lock     = threading.Lock()
+
+    def path(self, url):
+        return os.path.join(self.cacheDir, logicalFileName(url).lstrip('/'))
+
+    def lookup(self, url):
+        """Cached path of url, or None. Marks the file as recently used."""
+        path = self.path(url)
+        if not os.path.isfile(path):
+            return None
+        os.utime(path, None)
+        return path
+
+    def files(self):
+        for root, dirs, names in os.walk(self.cacheDir):
+            for name in names:
+                if name.endswith('.root') and '.tmp' not in name:
+                    yield os.path.join(root, name)
+
+    def evict(self, keep=()):
+        """Remove least recently used files until the cache fits in maxBytes"""
+        with self.lock:
+            entries = [(os.path.getmtime(f), os.path.getsize(f), f) for f in self.files()]
+            total   = sum(size for mtime, size, f in entries)
+            keep    = set(keep)
+            for mtime, size, f in sorted(entries):
+                if total <= self.maxBytes:
+                    break
+                if f in keep:
+                    continue
+                os.remove(f)
+                total -= size
+                print(' [muonInputCache] evicted %s' % f)
+
+    def fetch(self, url, redirectorDir='', reduce=True, reduceConfig='reduceMiniAOD_cfg.py'):
+        """Copy url into the cache, reduced to the analysisProducts by default"""
+        path = self.lookup(url)
+        if path:
+            return path
+
+        path = self.path(url)
+        tmp  = '%s.tmp%d.root' % (path[:-len('.root')], threading.current_thread().ident)
+
+        if not os.path.isdir(os.path.dirname(path)):
+            try:
+                os.makedirs(os.path.dirname(path))
+            except OSError:
+                pass  # created by another worker
+
+        source = sourceUrl(url, redirectorDir)
+
+        try:
+            if reduce:
+                subprocess.check_call(['cmsRun', reduceConfig, 'inputFiles=' + source, 'outputFile=' + tmp])
+            elif source.startswith('file:'):
+                shutil.copyfile(source[len('file:'):], tmp)
+            else:
+                subprocess.check_call(['xrdcp', '--silent', '--force', source, tmp])
+
+            # Readers never see a partially written file
+            os.rename(tmp, path)
+        finally:
+            if os.path.exists(tmp):
+                os.remove(tmp)
+
+        return path
+
+
+def prefetch(cache, urls, jobs=2, redirectorDir='', reduce=True, reduceConfig='reduceMiniAOD_cfg.py'):
+    """
+    Fetch urls into the cache with a pool of jobs workers, in order. Returns
+    a queue that receives (url, path or None, error or None) as files are
+    done, and (None, None, None) at the end.
+    """
+    todo = queue.Queue()
+    done = queue.Queue()
+
+    for url in urls:
+        todo.put(url)
+
+    def worker():
+        while True:
+            try:
+                url = todo.get_nowait()
+            except queue.Empty:
+                return
+            try:
+                done.put((url, cache.fetch(url, redirectorDir, reduce, reduceConfig), None))
+            except Exception as error:
+                done.put((url, None, error))
+
+    workers = [threading.Thread(target=worker) for i in range(max(1, jobs))]
+
+    for w in workers:
+        w.daemon = True
+        w.start()
+
+    def finish():
+        for w in workers:
+            w.join()
+        cache.evict(keep=[cache.path(url) for url in urls])
+        done.put((None, None, None))
+
+    threading.Thread(target=finish).start()
+
+    return done
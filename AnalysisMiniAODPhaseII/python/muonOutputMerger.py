@@ -0,0 +1,190 @@
+# Merge of ExampleMuonAnalyzer outputs
+#
+# Histograms are summed, trees are concatenated in input order, and the
+# configuration objects (PtBins, the TParameter cuts, Flavours) are written
+# once after checking that every input has the same ones. Objects are read one
+# key at a time, so a merge holds one histogram per input in memory. Many
+# inputs are merged as a tree of small merges, each level running in parallel.
+
+from __future__ import print_function
+
+import multiprocessing
+import os
+
+import ROOT
+
+
+# Histograms holding configuration, not counts
+configHistograms = ['PtBins']
+
+
+def mergeFiles(inputs, output):
+    """Merge the inputs into output, returns the list of problems found"""
+    ROOT.gROOT.SetBatch(True)
+    ROOT.TH1.AddDirectory(False)
+
+    files = [ROOT.TFile.Open(name) for name in inputs]
+
+    for name, f in zip(inputs, files):
+        if not f or f.IsZombie():
+            return ['cannot open %s' % name]
+
+    out = ROOT.TFile.Open(output, 'recreate')
+
+    problems = []
+
+    mergeDirectory(files, out, '', problems)
+
+    out.Close()
+
+    for f in files:
+        f.Close()
+
+    return problems
+
+
+def mergeDirectory(directories, out, path, problems):
+    seen = set()
+
+    for key in directories[0].GetListOfKeys():
+
+        # Highest cycle only
+        name = key.GetName()
+        if name in seen:
+            continue
+        seen.add(name)
+
+        keys = [d.GetKey(name) for d in directories]
+
+        if any(k is None for k in keys):
+            problems.append('%s%s is missing in some inputs' % (path, name))
+            continue
+
+        cls = ROOT.TClass.GetClass(key.GetClassName())
+
+        if cls.InheritsFrom('TDirectory'):
+            subdirectory = out.mkdir(name)
+            mergeDirectory([k.ReadObj() for k in keys], subdirectory, path + name + '/', problems)
+
+        elif cls.InheritsFrom('TTree'):
+            mergeTrees(keys, out)
+
+        elif cls.InheritsFrom('TH1') and name not in configHistograms:
+            mergeHistograms(keys, out)
+
+        else:
+            mergeConfiguration(keys, out, path, problems)
+
+
+def readObject(key):
+    obj = key.ReadObj()
+    ROOT.SetOwnership(obj, True)
+    return obj
+
+
+def mergeHistograms(keys, out):
+    total = readObject(keys[0])
+
+    for key in keys[1:]:
+        h = readObject(key)
+        total.Add(h)
+        del h
+
+    out.WriteTObject(total, keys[0].GetName())
+
+    del total
+
+
+def mergeTrees(keys, out):
+    out.cd()
+
+    first = keys[0].ReadObj()
+    tree  = first.CloneTree(-1, 'fast')
+
+    for key in keys[1:]:
+        tree.CopyEntries(key.ReadObj(), -1, 'fast')
+
+    out.WriteTObject(tree, keys[0].GetName())
+
+
+def mergeConfiguration(keys, out, path, problems):
+    first = readObject(keys[0])
+
+    for key in keys[1:]:
+        other = readObject(key)
+        if not sameConfiguration(first, other):
+            problems.append('%s%s differs between inputs' % (path, key.GetName()))
+        del other
+
+    out.WriteTObject(first, keys[0].GetName())
+
+
+def sameConfiguration(a, b):
+    if a.InheritsFrom('TH1'):
+        axis, other = a.GetXaxis(), b.GetXaxis()
+        return (axis.GetNbins() == other.GetNbins() and
+                all(axis.GetBinLowEdge(i) == other.GetBinLowEdge(i) for i in range(1, axis.GetNbins() + 2)))
+    if hasattr(a, 'GetVal'):
+        return a.GetVal() == b.GetVal()
+    return a.GetTitle() == b.GetTitle()
+
+
+def mergeTask(task):
+    inputs, output = task
+    return output, mergeFiles(inputs, output)
+
+
+def mergeOutputs(inputs, output, workDir, fanIn=2, jobs=1, keep=False):
+    """Tree reduction of inputs into output, fanIn files per merge.
+
+    Returns the list of problems found, empty when the merge succeeded.
+    """
+    if len(inputs) == 1:
+        return mergeFiles(inputs, output)
+
+    fanIn        = max(2, fanIn)
+    level        = 0
+    current      = list(inputs)
+    intermediate = []
+    problems     = []
+
+    pool = multiprocessing.Pool(max(1, jobs))
+
+    try:
+        while len(current) > 1:
+
+            groups = [current[i:i + fanIn] for i in range(0, len(current), fanIn)]
+
+            last = (len(groups) == 1)
+
+            tasks = []
+            for i, group in enumerate(groups):
+                if len(group) == 1:
+                    tasks.append(None)
+                else:
+                    target = output if last else os.path.join(workDir, 'merge_%d_%03d.root' % (level, i))
+                    tasks.append((group, target))
+
+            results = pool.map(mergeTask, [t for t in tasks if t])
+
+            intermediate += [t[1] for t in tasks if t and t[1] != output]
+
+            for target, found in results:
+                problems += found
+
+            if problems:
+                break
+
+            current = [group[0] if task is None else task[1] for group, task in zip(groups, tasks)]
+
+            level += 1
+    finally:
+        pool.close()
+        pool.join()
+
+    if not keep:
+        for name in intermediate:
+            if os.path.exists(name):
+                os.remove(name)
+
+    return problems
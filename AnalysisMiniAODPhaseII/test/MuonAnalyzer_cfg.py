@@ -1,6 +1,9 @@
 import FWCore.ParameterSet.Config as cms
 import FWCore.ParameterSet.VarParsing as opts
 
+from LeptonEfficiencies.AnalysisMiniAODPhaseII.muonDatasets   import datasets
+from LeptonEfficiencies.AnalysisMiniAODPhaseII.muonInputCache import InputCache, keepCommands, sourceUrl
+
 process = cms.Process("RecoMuon")
 
 options = opts.VarParsing('analysis')
@@ -11,8 +14,112 @@ options.register ('inputDataset',
                   opts.VarParsing.varType.string,
                   'Input dataset')
 
+options.register ('numberOfThreads',
+                  1,
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.int,
+                  'Number of threads')
+
+options.register ('numberOfStreams',
+                  0,
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.int,
+                  'Number of streams (0 means one per thread)')
+
+options.register ('writeNtuple',
+                  False,
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.bool,
+                  'Also write the MuonNtuple tree')
+
+options.register ('sweep',
+                  '',
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.string,
+                  'Also fill the working points of a predefined sweep: deltaR, vr, id or iso')
+
+options.register ('nReplicas',
+                  0,
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.int,
+                  'Bootstrap replicas of the efficiency histograms (0 means none)')
+
+options.register ('genIsoDeltaR',
+                  0.,
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.float,
+                  'Gen isolation cone of the gen muons, from packedGenParticles (0 means none, e.g. 0.4)')
+
+options.register ('isData',
+                  False,
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.bool,
+                  'Collision data: no gen matching and no gen isolation')
+
+options.register ('tagAndProbe',
+                  '',
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.string,
+                  'Also fill the tag-and-probe mass histograms of a resonance: Z or JPsi')
+
+options.register ('checkpointFile',
+                  '',
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.string,
+                  'Write the histograms and processed lumis to this file during the job')
+
+options.register ('checkpointEvents',
+                  0,
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.int,
+                  'Checkpoint after this many events (with checkpointMinutes 0 too, after every lumi)')
+
+options.register ('checkpointMinutes',
+                  0.,
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.float,
+                  'Checkpoint after this many minutes')
+
+options.register ('resumeFrom',
+                  '',
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.string,
+                  'Start from the histograms of a checkpoint and skip its lumis')
+
+options.register ('cacheDir',
+                  '',
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.string,
+                  'Local input cache, filled by prefetchInputs.py')
+
+options.register ('redirectorDir',
+                  '',
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.string,
+                  'Local /store/... tree replacing the xrootd redirector')
+
+options.setDefault('outputFile', 'MyMuonPlots.root')
+
 options.parseArguments()
 
+
+# Tag-and-probe windows: tag pt [GeV], mass window [GeV] and mass axis
+resonances = {
+    'Z'    : dict(tagMinPt = 26, minMass = 70,  maxMass = 110, nbins = 80),
+    'JPsi' : dict(tagMinPt = 8,  minMass = 2.8, maxMass = 3.4, nbins = 60),
+}
+
+if options.tagAndProbe and options.tagAndProbe not in resonances :
+    raise ValueError('Unknown tagAndProbe %s, expected one of %s' % (options.tagAndProbe, ', '.join(sorted(resonances))))
+
+resonance = resonances.get(options.tagAndProbe, resonances['Z'])
+
+if options.isData :
+    options.genIsoDeltaR = 0
+
+process.options = cms.untracked.PSet(numberOfThreads = cms.untracked.uint32(options.numberOfThreads),
+                                     numberOfStreams = cms.untracked.uint32(options.numberOfStreams))
+
 process.load("FWCore.MessageService.MessageLogger_cfi")
 process.MessageLogger.cerr.threshold = 'INFO'
 process.MessageLogger.categories.append('Demo')
@@ -20,70 +127,143 @@ process.MessageLogger.cerr.FwkReport.reportEvery = 1000
 process.MessageLogger.cerr.INFO = cms.untracked.PSet(limit = cms.untracked.int32(-1))
 
 
-if 'PU200' in options.inputDataset :
-    print '\n Will read /DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/PhaseIITDRSpring17MiniAOD-PU200BX8_91X_upgrade2023_realistic_v3-v6/MINIAODSIM\n'
-    options.inputFiles = \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/14211B25-C077-E711-90D0-0025905D1D78.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/1E5E5389-B477-E711-8518-0025905D1C56.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/5823B0EF-EB78-E711-A5B1-1866DAEA6E20.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/6671BA0A-9378-E711-8976-0025904C540C.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/68954ACD-E778-E711-BFE8-0025905521D2.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/70BEFF66-CD77-E711-B41D-B083FECFF2BE.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/7ADEB521-0578-E711-B0B4-842B2B1810D3.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/82597027-E577-E711-AC49-141877411D83.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/825E4ACC-BB77-E711-91D3-0025904C66EA.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/A0AA1AF5-9279-E711-9B35-782BCB5300A1.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/BC4957D1-C577-E711-8473-0025905D1CB6.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/D6BF7ECF-1E78-E711-A99D-B083FED429D5.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/DAE448AC-A977-E711-8A39-0025904C66A2.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/F0154A8B-F077-E711-95DC-141877410E71.root', \
-    'file:/afs/cern.ch/user/p/piedra/work/store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/PU200BX8_91X_upgrade2023_realistic_v3-v6/110000/F08EEFEF-DB77-E711-9912-A4BADB1C5E26.root'
-
-if 'noPU' in options.inputDataset :
-    print '\n Will read /DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/PhaseIITDRSpring17MiniAOD-noPUBX8_91X_upgrade2023_realistic_v3-v3/MINIAODSIM\n'
-    options.inputFiles = 'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedMuons_Pt2to50_Dxy0to500-pythia8-gun/MINIAODSIM/noPUBX8_91X_upgrade2023_realistic_v3-v3/50000/FCEFF295-A27C-E711-92A6-0CC47AD98CEA.root'
-
-
-if 'susy_pu' in options.inputDataset :
-    print '\n Will read /DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/PhaseIITDRSpring17MiniAOD-PU200_91X_upgrade2023_realistic_v3-v2/MINIAODSIM \n'
-    options.inputFiles ='root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/110000/1AD9250A-297F-E711-AD1B-48D539F38876.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/110000/A2DEC450-707E-E711-BD0E-00259048AE50.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/110000/BE2C32DF-097F-E711-B48B-0CC47A57CD56.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/110000/D0162FF4-287F-E711-8039-0CC47A57CCF4.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/110000/D2ACA348-557E-E711-AF2D-0CC47A4DEDFE.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/004CD079-877B-E711-AA24-00269E95B1BC.root',\
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/0628DE6A-517B-E711-AF5B-002590E7DE26.root',\
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/083AFF9C-0D7B-E711-9154-001E67E69E05.root',\
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/0C089C80-517B-E711-A8A2-008CFAF2222E.root',\
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/0CDD60CA-277B-E711-B0A9-6C3BE5B59150.root',\
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/0EA9129C-217B-E711-9675-0CC47A5FA3B9.root',
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/12C4CB84-E87A-E711-988E-0242AC1C0501.root',
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/1C3CC775-F77A-E711-8AF0-0CC47AD98CF2.root',
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/34650372-877B-E711-B277-A0369FC5B844.root',
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/3E2B439C-E97A-E711-B783-00266CFFC80C.root',
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/46DFDA8C-457B-E711-BD37-008CFA197480.root',
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/4A8F61D3-427A-E711-BA3D-008CFA14FA8C.root',
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/562EBE89-567B-E711-BC50-0025907B4EEE.root',
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/5AFDDB67-5F7B-E711-B319-3417EBE5062D.root',
-    'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/PU200_91X_upgrade2023_realistic_v3-v2/70000/5E94E2F5-167B-E711-8AEF-549F3525DB98.root'
-
-
-if 'susy_0pu' in options.inputDataset :
-    print '\n Will read /DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/PhaseIITDRSpring17MiniAOD_noPU_91X_upgrade2023_realistic_v3-v2/MINIAODSIM \n'
-    options.inputFiles ='root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/noPU_91X_upgrade2023_realistic_v3-v2/50000/AA5A0677-FD7D-E711-AA69-48FD8EE73A8D.root', 'root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/noPU_91X_upgrade2023_realistic_v3-v2/70000/00A47E5F-C47A-E711-87C2-0CC47AD98D6C.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/noPU_91X_upgrade2023_realistic_v3-v2/70000/149EF07A-C47A-E711-971B-00259074AE54.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/noPU_91X_upgrade2023_realistic_v3-v2/70000/1EF1CCD3-787A-E711-9BE0-1866DAEA7A40.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/noPU_91X_upgrade2023_realistic_v3-v2/70000/282CCB76-C47A-E711-969B-0242AC110009.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/noPU_91X_upgrade2023_realistic_v3-v2/70000/2E1DDD0D-C07A-E711-BB26-7845C4FC3C98.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/noPU_91X_upgrade2023_realistic_v3-v2/70000/3C0EA981-457A-E711-B93B-A0369F3102F6.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/noPU_91X_upgrade2023_realistic_v3-v2/70000/42B5A080-C47A-E711-8581-008CFAF5592A.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/noPU_91X_upgrade2023_realistic_v3-v2/70000/48FEC467-C47A-E711-9225-003048C8F3A2.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/noPU_91X_upgrade2023_realistic_v3-v2/70000/586E1B91-C47A-E711-A6AE-D4AE526A0419.root','root://cms-xrd-global.cern.ch//store/mc/PhaseIITDRSpring17MiniAOD/DisplacedSUSY_SmuonToMuNeutralino_M-200_CTau-1_TuneCUETP8M1_14TeV-pythia8/MINIAODSIM/noPU_91X_upgrade2023_realistic_v3-v2/70000/6ABB5C53-CB7A-E711-BBBC-0CC47ABB5178.root', 
-
-
-process.source = cms.Source("PoolSource", fileNames = cms.untracked.vstring(options.inputFiles))
+# inputFiles, e.g. the output of skimMuons_cfg.py, take precedence over inputDataset
+if options.inputFiles :
+    print '\n Will read %d input files\n' % len(options.inputFiles)
+elif options.inputDataset in datasets :
+    print '\n Will read %s\n' % datasets[options.inputDataset]['das']
+    options.inputFiles = datasets[options.inputDataset]['files']
+else :
+    raise ValueError('Unknown inputDataset %s, expected one of %s' % (options.inputDataset, ', '.join(sorted(datasets))))
+
+
+# Collections read on top of the analysisProducts of muonInputCache.py
+extraProducts = []
+if options.tagAndProbe :
+    extraProducts.append('packedPFCandidates')
+if options.genIsoDeltaR > 0 :
+    extraProducts.append('packedGenParticles')
+
+
+# Read the reduced copies of the local cache when available (see prefetchInputs.py).
+# They only keep the analysisProducts, so tag and probe and the gen isolation
+# read the original files.
+if options.cacheDir and extraProducts :
+    print ' %s not in the cached copies: %s is not used\n' % (', '.join(extraProducts), options.cacheDir)
+    options.inputFiles = [sourceUrl(url, options.redirectorDir) for url in options.inputFiles]
+elif options.cacheDir :
+    cache = InputCache(options.cacheDir)
+    inputFiles = []
+    for url in options.inputFiles :
+        path = cache.lookup(url)
+        inputFiles.append('file:' + path if path else sourceUrl(url, options.redirectorDir))
+    print ' %d of %d files read from %s\n' % (len([f for f in inputFiles if f.startswith('file:' + cache.cacheDir)]), len(inputFiles), cache.cacheDir)
+    options.inputFiles = inputFiles
+else :
+    options.inputFiles = [sourceUrl(url, options.redirectorDir) for url in options.inputFiles]
+
+
+# Only read the collections used by the analyzer, and prefetch the next
+# baskets of the current file while the events are processed
+process.source = cms.Source("PoolSource",
+                            fileNames = cms.untracked.vstring(options.inputFiles),
+                            inputCommands = cms.untracked.vstring(keepCommands(extraProducts)),
+                            dropDescendantsOfDroppedBranches = cms.untracked.bool(False),
+                            enablePrefetching = cms.untracked.bool(True))
+
+
+# Lumis already in the checkpoint are not read again
+if options.resumeFrom :
+    import ROOT
+    checkpoint = ROOT.TFile.Open(options.resumeFrom)
+    lumis = checkpoint.Get('muonAnalysis/ProcessedLumis') if checkpoint else None
+    if not lumis :
+        raise ValueError('%s is not a checkpoint of muonAnalysis' % options.resumeFrom)
+    ranges = [r for r in lumis.GetTitle().split(',') if r]
+    checkpoint.Close()
+    print ' Resuming from %s, skipping %d lumi ranges\n' % (options.resumeFrom, len(ranges))
+    process.source.lumisToSkip = cms.untracked.VLuminosityBlockRange(ranges)
 
 
 #process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(3000))
-process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(-1))
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
 
 process.TFileService=cms.Service('TFileService',
-                                 fileName=cms.string('MyMuonPlots.root')
+                                 fileName=cms.string(options.outputFile)
                                  )
 
+def axis(nbins, xmin, xmax):
+    return cms.PSet(nbins = cms.int32(nbins), min = cms.double(xmin), max = cms.double(xmax))
+
+
+# Working points filled in the same pass, each in muonAnalysis/<name>. A point
+# can change maxDeltaR, maxVr, id and maxChargeIso.
+def point(name, **cuts):
+    pset = cms.PSet(name = cms.string(name))
+    for cut, value in cuts.items():
+        setattr(pset, cut, cms.string(value) if cut == 'id' else cms.double(value))
+    return pset
+
+sweeps = {
+    'deltaR' : [point('dR01', maxDeltaR = 0.1), point('dR02', maxDeltaR = 0.2)],
+    'vr'     : [point('vr10', maxVr = 10), point('vr100', maxVr = 100), point('vr500', maxVr = 500)],
+    'id'     : [point('Soft', id = 'Soft'), point('Medium', id = 'Medium')],
+    'iso'    : [point('Iso015', maxChargeIso = 0.15), point('SoftIso015', id = 'Soft', maxChargeIso = 0.15)],
+}
+
+if options.sweep and options.sweep not in sweeps :
+    raise ValueError('Unknown sweep %s, expected one of %s' % (options.sweep, ', '.join(sorted(sweeps))))
+
 process.muonAnalysis = cms.EDAnalyzer("ExampleMuonAnalyzer",
                                       MuonCollection = cms.InputTag('slimmedMuons'),
                                       packed = cms.InputTag("packedGenParticles"),
                                       pruned = cms.InputTag("prunedGenParticles"),
+                                      pfCandidates = cms.InputTag("packedPFCandidates"),
                                       vertices = cms.InputTag("offlineSlimmedPrimaryVertices"),
-                                      beamSpot = cms.InputTag("offlineBeamSpot")
+                                      beamSpot = cms.InputTag("offlineBeamSpot"),
+                                      writeNtuple = cms.bool(options.writeNtuple),
+                                      ptBins = cms.vdouble(10, 20, 35, 50),
+                                      maxDeltaR = cms.double(0.3),
+                                      maxVr = cms.double(50),  # [cm]
+                                      maxEta = cms.double(2.4),
+                                      id = cms.string('Tight'),  # Tight, Soft or Medium
+                                      maxChargeIso = cms.double(-1),  # negative for no cut
+                                      nReplicas = cms.int32(options.nReplicas),
+                                      genIsoDeltaR = cms.double(options.genIsoDeltaR),
+                                      genIsoMinPt = cms.double(0.5),  # [GeV]
+                                      genMatching = cms.bool(not options.isData),
+                                      tagAndProbe = cms.bool(options.tagAndProbe != ''),
+                                      tagMinPt = cms.double(resonance['tagMinPt']),  # [GeV]
+                                      tagMaxIso = cms.double(0.15),
+                                      minMass = cms.double(resonance['minMass']),  # [GeV]
+                                      maxMass = cms.double(resonance['maxMass']),  # [GeV]
+                                      checkpointFile = cms.string(options.checkpointFile),
+                                      checkpointEvents = cms.uint32(options.checkpointEvents),
+                                      checkpointMinutes = cms.double(options.checkpointMinutes),
+                                      resumeFrom = cms.string(options.resumeFrom),
+                                      sweep = cms.VPSet(sweeps.get(options.sweep, [])),
+                                      flavours = cms.vstring('Tight', 'Sta', 'Trk', 'Glb'),
+                                      binning = cms.PSet(eta = axis(100, -2.5, 2.5),
+                                                         phi = axis(100, -3.2, 3.2),
+                                                         pt = axis(100, 0, 100),
+                                                         vxyz = axis(150, 0, 750),
+                                                         vr = axis(750, 0, 750),
+                                                         dxy = axis(100, 0, 50),  # |dxy| from the primary vertex
+                                                         lxy = axis(150, 0, 750),
+                                                         ipSig = axis(100, 0, 100),
+                                                         dR = axis(100, 0, 4),
+                                                         res = axis(60, -0.1, 0.1),
+                                                         staRes = axis(60, -1, 1),
+                                                         eta2D = axis(50, -2.5, 2.5),
+                                                         phi2D = axis(50, -3.2, 3.2),
+                                                         iso = axis(200, 0, 1),
+                                                         isoVr = axis(100, 0, 15),
+                                                         isoSumPt = axis(100, 0, 0.5),
+                                                         genNearestDR = axis(80, 0, 0.4),
+                                                         mass = axis(resonance['nbins'], resonance['minMass'], resonance['maxMass']),
+                                                         stageTime = axis(200, 0, 2000),  # [us]
+                                                         multiplicity = axis(100, 0, 100),
+                                                         deltaRComputed = axis(200, 0, 2000))
                                       )
 
 process.p = cms.Path(process.muonAnalysis)
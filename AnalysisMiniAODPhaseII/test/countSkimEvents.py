@@ -0,0 +1,33 @@
+#!/usr/bin/env python
+#
+# Event counts before and after GenMuonFilter, summed over the luminosity
+# blocks of skimMuons_cfg.py outputs. The total is the normalisation of the
+# histograms made from the skim.
+#
+#   ./countSkimEvents.py MuonSkim_PU200.root
+
+from __future__ import print_function
+
+import sys
+
+from DataFormats.FWLite import Handle, Lumis
+
+
+def main(files):
+    counter = Handle('edm::MergeableCounter')
+    counts  = {'nEventsTotal': 0, 'nEventsSkimmed': 0}
+
+    for lumi in Lumis(files):
+        for label in counts:
+            lumi.getByLabel(label, counter)
+            counts[label] += counter.product().value
+
+    print(' events before the skim: %d' % counts['nEventsTotal'])
+    print(' events after the skim:  %d' % counts['nEventsSkimmed'])
+
+    if counts['nEventsTotal'] > 0:
+        print(' fraction kept:          %.4f' % (float(counts['nEventsSkimmed']) / counts['nEventsTotal']))
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+#
+# Fill the local input cache of MuonAnalyzer_cfg.py, and optionally run the
+# analysis while the remaining files are being fetched
+#
+#   ./prefetchInputs.py --dataset PU200 --cache-dir /tmp/$USER/muoncache --jobs 4
+#   ./prefetchInputs.py --dataset susy_pu --cache-dir /tmp/$USER/muoncache --redirector-dir /data/store-mirror \
+#                       --run "cmsRun MuonAnalyzer_cfg.py inputDataset=susy_pu"
+#
+# With --run the command starts as soon as the first file is cached, with
+# cacheDir pointing at the cache. The files already cached when cmsRun starts
+# are read locally, and the others from their source, so a slow or failed
+# fetch never stops the job. The workers keep filling the cache for the next
+# runs.
+
+from __future__ import print_function
+
+import argparse
+import os
+import shlex
+import subprocess
+import sys
+
+try:
+    from LeptonEfficiencies.AnalysisMiniAODPhaseII.muonDatasets   import datasets
+    from LeptonEfficiencies.AnalysisMiniAODPhaseII.muonInputCache import InputCache, prefetch
+except ImportError:
+    sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'python'))
+    from muonDatasets   import datasets
+    from muonInputCache import InputCache, prefetch
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Prefetch MINIAOD files into the local input cache')
+    parser.add_argument('--dataset',        required=True, choices=sorted(datasets.keys()))
+    parser.add_argument('--cache-dir',      required=True)
+    parser.add_argument('--cache-size',     type=float, default=50, help='cache size limit [GB]')
+    parser.add_argument('--jobs',           type=int,   default=2,  help='files fetched in parallel')
+    parser.add_argument('--redirector-dir', default='', help='local /store/... tree replacing the xrootd redirector')
+    parser.add_argument('--no-reduce',      action='store_true', help='cache full files instead of reduced copies')
+    parser.add_argument('--run',            default='', help='command to run on the cached files')
+    args = parser.parse_args()
+
+    cache = InputCache(args.cache_dir, int(args.cache_size * 1024**3))
+    urls  = datasets[args.dataset]['files']
+
+    cached  = [url for url in urls if cache.lookup(url)]
+    pending = [url for url in urls if url not in cached]
+
+    print('\n [prefetchInputs] %s: %d files cached, %d to fetch\n' % (args.dataset, len(cached), len(pending)))
+
+    done = prefetch(cache, pending, args.jobs, args.redirector_dir, not args.no_reduce)
+
+    job    = None
+    failed = 0
+
+    if args.run and cached:
+        job = start(args)
+
+    while True:
+        url, path, error = done.get()
+        if url is None:
+            break
+        if error:
+            failed += 1
+            print(' [prefetchInputs] failed %s: %s' % (url, error))
+        else:
+            print(' [prefetchInputs] cached %s' % path)
+        if args.run and not job and not error:
+            job = start(args)
+
+    if job:
+        return job.wait() or (1 if failed else 0)
+
+    return 1 if failed else 0
+
+
+def start(args):
+    command = shlex.split(args.run) + ['cacheDir=' + os.path.abspath(args.cache_dir)]
+    if args.redirector_dir:
+        command.append('redirectorDir=' + os.path.abspath(args.redirector_dir))
+
+    print('\n [prefetchInputs] running %s\n' % ' '.join(command))
+
+    return subprocess.Popen(command)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,29 @@
+import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as opts
+
+from LeptonEfficiencies.AnalysisMiniAODPhaseII.muonInputCache import keepCommands
+
+# Copy of a MINIAOD file with only the collections read by
+# ExampleMuonAnalyzer, used to fill the local input cache
+
+process = cms.Process("ReduceMuon")
+
+options = opts.VarParsing('analysis')
+
+options.parseArguments()
+
+process.load("FWCore.MessageService.MessageLogger_cfi")
+process.MessageLogger.cerr.FwkReport.reportEvery = 1000
+
+process.source = cms.Source("PoolSource",
+                            fileNames = cms.untracked.vstring(options.inputFiles),
+                            inputCommands = cms.untracked.vstring(keepCommands()),
+                            dropDescendantsOfDroppedBranches = cms.untracked.bool(False))
+
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(-1))
+
+process.out = cms.OutputModule("PoolOutputModule",
+                               fileName = cms.untracked.string(options.outputFile),
+                               outputCommands = cms.untracked.vstring(keepCommands()))
+
+process.e = cms.EndPath(process.out)
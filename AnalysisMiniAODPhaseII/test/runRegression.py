@@ -0,0 +1,289 @@
+#!/usr/bin/env python
+#
+# Regression check of ExampleMuonAnalyzer: runs MuonAnalyzer_cfg.py on a small
+# input at several thread counts, compares every output bin for bin with a
+# golden output, and compares the throughput with a stored baseline
+#
+#   ./runRegression.py --update-baseline
+#   ./runRegression.py
+#   ./runRegression.py --input-files file:MuonSkim_PU200.root --update-golden --update-baseline -- sweep=vr
+#
+# Without --dataset or --input-files the input is regression/MuonRegression_PU200.root,
+# the skim of the first regressionEvents events of the first PU200 file, and
+# the golden output is regression/golden.root. Both belong in the repository.
+# The skim is made again with skimMuons_cfg.py, one thread so that the events
+# keep their order, when it is missing. The output does not depend on the
+# machine or on the number of threads, so the golden output only changes with
+# the analyzer, and --update-golden (from the first thread count) is then
+# committed with it. Other inputs and options keep their golden output in
+# --work-dir.
+#
+# The events/s depend on the machine, so the baseline is kept in --work-dir and
+# written with --update-baseline on the machine the check runs on, or by the
+# first run without one. The job fails when an output differs from the golden
+# one, or when the events/s of a thread count drop by more than --max-slowdown
+# from the baseline. Every run appends a line with the events/s, peak RSS and
+# scratch buffer growths per event of the analyzer to --results, so the
+# history can be plotted. The heap allocations per event are not those of
+# cmsRun, which also counts the framework ones: they come from the standalone
+# benchmarkMatching.C, which runs the same matching and filling code, and are
+# stored as benchmarkAllocationsPerEvent. The outputs and logs of the runs
+# also go to --work-dir.
+#
+# scram b runtests runs it through test/BuildFile.xml.
+
+from __future__ import print_function
+
+import argparse
+import datetime
+import json
+import os
+import shutil
+import socket
+import subprocess
+import sys
+
+import ROOT
+
+try:
+    from LeptonEfficiencies.AnalysisMiniAODPhaseII.muonDatasets import datasets
+except ImportError:
+    sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'python'))
+    from muonDatasets import datasets
+
+
+testDir = os.path.dirname(os.path.abspath(__file__))
+
+# Input and golden output kept in the repository
+regressionDir    = os.path.join(testDir, 'regression')
+regressionInput  = os.path.join(regressionDir, 'MuonRegression_PU200.root')
+regressionGolden = os.path.join(regressionDir, 'golden.root')
+regressionSource = datasets['PU200']['files'][0]
+regressionEvents = 2000  # events of regressionSource read by the skim
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Check the output and the throughput of MuonAnalyzer_cfg.py against a golden output and a baseline')
+    parser.add_argument('--dataset',          default='',  help='dataset of muonDatasets.py')
+    parser.add_argument('--input-files',      default='',  help='comma separated, instead of --dataset')
+    parser.add_argument('--max-events',       type=int, default=-1, help='-1 for all')
+    parser.add_argument('--threads',          default='1,4,8', help='comma separated thread counts, one stream per thread')
+    parser.add_argument('--work-dir',         default='regressionRuns')
+    parser.add_argument('--results',          default='', help='default <work-dir>/results.jsonl')
+    parser.add_argument('--max-slowdown',     type=float, default=0.10, help='largest events/s loss from the baseline')
+    parser.add_argument('--benchmark-events', type=int, default=2000, help='events of benchmarkMatching.C for the allocations per event, 0 to skip it')
+    parser.add_argument('--update-golden',    action='store_true', help='write the golden output')
+    parser.add_argument('--update-baseline',  action='store_true', help='write the events/s baseline of this machine')
+    parser.add_argument('cmsRunArgs',         nargs=argparse.REMAINDER, help='-- followed by MuonAnalyzer_cfg.py options')
+    args = parser.parse_args()
+
+    threads = [int(n) for n in args.threads.split(',') if n]
+    extra   = [a for a in args.cmsRunArgs if a != '--']
+
+    workDir  = os.path.abspath(args.work_dir)
+    baseline = os.path.join(workDir, 'baseline.json')
+    results  = os.path.abspath(args.results or os.path.join(workDir, 'results.jsonl'))
+
+    if not os.path.isdir(workDir):
+        os.makedirs(workDir)
+
+    # The golden output of the repository only holds for its input and options
+    if args.input_files:
+        inputs = ['inputFiles=' + args.input_files]
+        golden = os.path.join(workDir, 'golden.root')
+    elif args.dataset:
+        inputs = ['inputDataset=' + args.dataset]
+        golden = os.path.join(workDir, 'golden.root')
+    else:
+        if not os.path.exists(regressionInput) and makeInput(workDir) != 0:
+            return 1
+        inputs = ['inputFiles=file:' + regressionInput]
+        golden = regressionGolden if args.max_events < 0 and not extra else os.path.join(workDir, 'golden.root')
+
+    if not args.update_golden and not os.path.exists(golden):
+        print(' [runRegression] no golden output %s, run with --update-golden first' % golden)
+        return 1
+
+    if not args.update_baseline and not os.path.exists(baseline):
+        print(' [runRegression] no baseline in %s, this run writes it' % workDir)
+        args.update_baseline = True
+
+    ROOT.gROOT.SetBatch(True)
+    ROOT.gROOT.LoadMacro(os.path.join(testDir, 'compareOutputs.C') + '+')
+
+    record = {'date':    datetime.datetime.now().isoformat(),
+              'host':    socket.gethostname(),
+              'commit':  gitCommit(),
+              'input':   args.input_files or args.dataset or regressionInput,
+              'events':  args.max_events,
+              'options': extra,
+              'runs':    {}}
+
+    failures = []
+
+    for n in threads:
+
+        output = os.path.join(workDir, 'output_%dthreads.root' % n)
+        log    = os.path.join(workDir, 'output_%dthreads.log'  % n)
+
+        command = ['cmsRun', os.path.join(testDir, 'MuonAnalyzer_cfg.py'),
+                   'numberOfThreads=%d' % n, 'maxEvents=%d' % args.max_events, 'outputFile=' + output] + inputs + extra
+
+        print(' [runRegression] %d threads, log in %s' % (n, log))
+
+        status, maxRssKB = runLogged(command, log)
+
+        if status != 0:
+            failures.append('cmsRun failed with %d threads, see %s' % (n, log))
+            continue
+
+        run = readPerformance(output)
+
+        run['peakRssMB'] = maxRssKB / 1024.
+
+        # The first output of an update is the golden one, the others are
+        # still compared with it
+        if args.update_golden and n == threads[0]:
+            shutil.copyfile(output, golden)
+            print(' [runRegression] golden output written to %s' % golden)
+
+        run['different'] = ROOT.compareOutputs(golden, output)
+
+        if run['different'] != 0:
+            failures.append('%d threads: %d histograms differ from %s' % (n, run['different'], golden))
+
+        record['runs'][str(n)] = run
+
+        print(' [runRegression] %d threads: %.1f events/s, %.0f MB peak RSS, %.4f scratch growths/event, %d histograms differ\n'
+              % (n, run['eventsPerSecond'], run['peakRssMB'], run['scratchGrowthsPerEvent'], run['different']))
+
+    if args.benchmark_events > 0:
+        record['benchmarkAllocationsPerEvent'] = benchmarkAllocations(workDir, args.benchmark_events)
+        print(' [runRegression] standalone benchmarkMatching.C, not cmsRun, allocations per event: %s\n'
+              % ', '.join('PU %s %s' % (pu, allocs) for pu, allocs in sorted(record['benchmarkAllocationsPerEvent'].items(), key=lambda i: int(i[0]))))
+
+    if args.update_baseline and not failures:
+        with open(baseline, 'w') as f:
+            json.dump(dict((n, run['eventsPerSecond']) for n, run in record['runs'].items()), f, indent=2, sort_keys=True)
+        print(' [runRegression] baseline written to %s' % baseline)
+
+    elif not args.update_baseline:
+        with open(baseline) as f:
+            reference = json.load(f)
+
+        for n, run in sorted(record['runs'].items(), key=lambda i: int(i[0])):
+            if n not in reference:
+                print(' [runRegression] no baseline for %s threads' % n)
+                continue
+            change = run['eventsPerSecond'] / reference[n] - 1
+            run['baselineChange'] = change
+            print(' [runRegression] %s threads: %+.1f%% events/s from the baseline' % (n, 100 * change))
+            if change < -args.max_slowdown:
+                failures.append('%s threads: %.1f events/s, %.1f%% below the baseline %.1f'
+                                % (n, run['eventsPerSecond'], -100 * change, reference[n]))
+
+    record['failures'] = failures
+
+    with open(results, 'a') as f:
+        f.write(json.dumps(record, sort_keys=True) + '\n')
+
+    print('\n [runRegression] results appended to %s' % results)
+
+    for failure in failures:
+        print(' [runRegression] FAILED: %s' % failure)
+
+    return 1 if failures else 0
+
+
+def makeInput(workDir):
+    """Skim the first regressionEvents events of regressionSource into regressionInput"""
+    if not os.path.isdir(regressionDir):
+        os.makedirs(regressionDir)
+
+    log = os.path.join(workDir, 'skim.log')
+
+    print(' [runRegression] making %s from %s, log in %s' % (regressionInput, regressionSource, log))
+
+    status, _ = runLogged(['cmsRun', os.path.join(testDir, 'skimMuons_cfg.py'), 'numberOfThreads=1',
+                           'inputFiles=' + regressionSource, 'maxEvents=%d' % regressionEvents,
+                           'outputFile=' + regressionInput], log)
+
+    if status != 0:
+        print(' [runRegression] the skim failed, see %s' % log)
+        if os.path.exists(regressionInput):
+            os.remove(regressionInput)
+
+    return status
+
+
+def runLogged(command, log):
+    """Run command with its output in log, returns its exit status and peak RSS [kB]"""
+    with open(log, 'w') as f:
+        process = subprocess.Popen(command, stdout=f, stderr=subprocess.STDOUT)
+        _, status, usage = os.wait4(process.pid, 0)
+
+    # ru_maxrss of this process only, in kB on Linux
+    return os.WEXITSTATUS(status) if os.WIFEXITED(status) else 1, usage.ru_maxrss
+
+
+def readPerformance(output):
+    """Events/s and counters of the Performance tree of an output"""
+    f    = ROOT.TFile.Open(output)
+    tree = f.Get('muonAnalysis/instrumentation/Performance')
+
+    events   = 0
+    growths  = 0
+    wallTime = 0
+    peak     = 0
+
+    for entry in tree:
+        events  += entry.events
+        growths += entry.scratchGrowths
+        wallTime = entry.wallTime
+        peak     = max(peak, entry.peakScratchBytes)
+
+    f.Close()
+
+    return {'events':                 events,
+            'wallSeconds':            wallTime,
+            'eventsPerSecond':        events / wallTime if wallTime > 0 else 0.,
+            'scratchGrowthsPerEvent': float(growths) / events if events > 0 else 0.,
+            'peakScratchKB':          peak / 1024.}
+
+
+def benchmarkAllocations(workDir, nEvents):
+    """Heap allocations per event of each PU scenario of the standalone benchmarkMatching.C"""
+    binary = os.path.join(workDir, 'benchmarkMatching')
+    flags  = subprocess.check_output(['root-config', '--cflags', '--libs']).decode().split()
+
+    subprocess.check_call(['g++', '-O2', '-std=c++14', '-DBENCHMARK_MAIN', '-o', binary,
+                           os.path.join(testDir, 'benchmarkMatching.C')] + flags)
+
+    lines = subprocess.check_output([binary, str(nEvents), '1']).decode().splitlines()
+
+    # Rows of the first table, from its header up to the empty line that ends it
+    allocations = {}
+    column      = None
+
+    for line in lines:
+        fields = line.split()
+        if column is None:
+            if 'allocs/evt' in fields:
+                column = fields.index('allocs/evt')
+            continue
+        if not fields:
+            break
+        allocations[fields[0]] = float(fields[column]) if fields[column] != 'n/a' else None
+
+    return allocations
+
+
+def gitCommit():
+    try:
+        return subprocess.check_output(['git', 'rev-parse', '--short', 'HEAD'], cwd=testDir).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return ''
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,136 @@
+#!/usr/bin/env python
+#
+# Split the input files of MuonAnalyzer_cfg.py into shards, run one cmsRun per
+# shard in parallel and merge their outputs
+#
+#   ./runShards.py --dataset PU200 --shards 8 --jobs 4 --output rootfiles/MyMuonPlots_PU200.root
+#   ./runShards.py --dataset susy_pu --jobs 8 --output rootfiles/MyMuonPlots_susy_pu.root -- writeNtuple=True
+#
+# Each shard reads a contiguous block of the file list and the merge keeps the
+# shard order, so the merged histograms are the ones of a single job over the
+# whole list. The merge is a tree of --fan-in files per step, running --jobs
+# steps at a time. Shard outputs and logs go to --work-dir. A shard output
+# gets its final name when cmsRun succeeds, and shards whose output is already
+# there are not run again.
+
+from __future__ import print_function
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+try:
+    from LeptonEfficiencies.AnalysisMiniAODPhaseII.muonDatasets     import datasets
+    from LeptonEfficiencies.AnalysisMiniAODPhaseII.muonOutputMerger import mergeOutputs
+except ImportError:
+    sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'python'))
+    from muonDatasets     import datasets
+    from muonOutputMerger import mergeOutputs
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Run MuonAnalyzer_cfg.py in parallel shards and merge the outputs')
+    parser.add_argument('--dataset',     default='',  choices=[''] + sorted(datasets.keys()))
+    parser.add_argument('--input-files', default='',  help='comma separated, instead of --dataset')
+    parser.add_argument('--output',      required=True)
+    parser.add_argument('--shards',      type=int, default=0, help='default is one per job')
+    parser.add_argument('--jobs',        type=int, default=4, help='cmsRun jobs and merges run in parallel')
+    parser.add_argument('--fan-in',      type=int, default=2, help='files per merge step')
+    parser.add_argument('--work-dir',    default='',  help='shard outputs and logs, default shards_<output name>')
+    parser.add_argument('--keep',        action='store_true', help='keep the intermediate merges')
+    parser.add_argument('cmsRunArgs',    nargs=argparse.REMAINDER, help='-- followed by MuonAnalyzer_cfg.py options')
+    args = parser.parse_args()
+
+    if args.input_files:
+        files = [f for f in args.input_files.split(',') if f]
+    elif args.dataset:
+        files = datasets[args.dataset]['files']
+    else:
+        parser.error('either --dataset or --input-files is needed')
+
+    extra = [a for a in args.cmsRunArgs if a != '--']
+
+    nShards = min(len(files), args.shards if args.shards > 0 else args.jobs)
+    workDir = os.path.abspath(args.work_dir or 'shards_' + os.path.splitext(os.path.basename(args.output))[0])
+    config  = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'MuonAnalyzer_cfg.py')
+
+    if not os.path.isdir(workDir):
+        os.makedirs(workDir)
+
+    outputs  = []
+    commands = []
+    logs     = []
+
+    for i in range(nShards):
+        shard  = files[len(files) * i // nShards : len(files) * (i + 1) // nShards]
+        output = os.path.join(workDir, 'shard_%03d.root' % i)
+        outputs .append(output)
+        commands.append(['cmsRun', config, 'inputFiles=' + ','.join(shard), 'outputFile=' + temporary(output)] + extra)
+        logs    .append(os.path.join(workDir, 'shard_%03d.log' % i))
+
+    todo = [i for i in range(nShards) if not os.path.exists(outputs[i])]
+
+    print('\n [runShards] %d files in %d shards, %d to run, %d at a time\n' % (len(files), nShards, len(todo), args.jobs))
+
+    start  = time.time()
+    failed = run(commands, logs, outputs, todo, args.jobs)
+
+    if failed:
+        for i in failed:
+            print(' [runShards] shard %d failed, see %s' % (i, logs[i]))
+        return 1
+
+    print('\n [runShards] shards done in %.0f s, merging into %s\n' % (time.time() - start, args.output))
+
+    problems = mergeOutputs(outputs, os.path.abspath(args.output), workDir, args.fan_in, args.jobs, args.keep)
+
+    for problem in problems:
+        print(' [runShards] %s' % problem)
+
+    if problems:
+        return 1
+
+    print(' [runShards] %s written in %.0f s\n' % (args.output, time.time() - start))
+
+    return 0
+
+
+def temporary(output):
+    return output[:-len('.root')] + '.tmp.root'
+
+
+def run(commands, logs, outputs, todo, jobs):
+    """Run the todo commands, jobs at a time, returns the failed ones"""
+    pending = list(todo)
+    running = []
+    failed  = []
+
+    while pending or running:
+
+        while pending and len(running) < jobs:
+            i   = pending.pop(0)
+            log = open(logs[i], 'w')
+            running.append((i, subprocess.Popen(commands[i], stdout=log, stderr=subprocess.STDOUT), log))
+
+        time.sleep(1)
+
+        for job in list(running):
+            i, process, log = job
+            if process.poll() is None:
+                continue
+            log.close()
+            running.remove(job)
+            # Only finished shards get their final name
+            if process.returncode == 0:
+                os.rename(temporary(outputs[i]), outputs[i])
+            else:
+                failed.append(i)
+            print(' [runShards] shard %d %s' % (i, 'failed' if process.returncode else 'done'))
+
+    return sorted(failed)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
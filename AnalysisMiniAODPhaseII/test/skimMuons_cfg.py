@@ -0,0 +1,82 @@
+import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as opts
+
+from LeptonEfficiencies.AnalysisMiniAODPhaseII.muonDatasets   import datasets
+from LeptonEfficiencies.AnalysisMiniAODPhaseII.muonInputCache import keepCommands, sourceUrl
+
+# Slimmed input for MuonAnalyzer_cfg.py: only the collections read by the
+# analyzer, only the events with a gen muon in acceptance. The event counts
+# before and after the filter are stored per luminosity block, as
+# edm::MergeableCounter products nEventsTotal and nEventsSkimmed.
+#
+#   cmsRun skimMuons_cfg.py inputDataset=PU200 outputFile=MuonSkim_PU200.root
+#   cmsRun skimMuons_cfg.py inputDataset=PU200 outputFile=MuonSkim_PU200.root keepPackedGen=True
+#   cmsRun MuonAnalyzer_cfg.py inputFiles=file:MuonSkim_PU200.root
+
+process = cms.Process("SkimMuon")
+
+options = opts.VarParsing('analysis')
+
+options.register ('inputDataset',
+                  'PU200',
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.string,
+                  'Input dataset')
+
+options.register ('redirectorDir',
+                  '',
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.string,
+                  'Local /store/... tree replacing the xrootd redirector')
+
+options.register ('numberOfThreads',
+                  1,
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.int,
+                  'Number of threads')
+
+options.register ('keepPackedGen',
+                  False,
+                  opts.VarParsing.multiplicity.singleton,
+                  opts.VarParsing.varType.bool,
+                  'Also keep packedGenParticles, for genIsoDeltaR > 0')
+
+options.setDefault('outputFile', 'MuonSkim.root')
+
+options.parseArguments()
+
+extraProducts = ['packedGenParticles'] if options.keepPackedGen else []
+
+if not options.inputFiles :
+    options.inputFiles = datasets[options.inputDataset]['files']
+
+process.options = cms.untracked.PSet(numberOfThreads = cms.untracked.uint32(options.numberOfThreads),
+                                     wantSummary = cms.untracked.bool(True))
+
+process.load("FWCore.MessageService.MessageLogger_cfi")
+process.MessageLogger.cerr.FwkReport.reportEvery = 1000
+
+process.source = cms.Source("PoolSource",
+                            fileNames = cms.untracked.vstring([sourceUrl(f, options.redirectorDir) for f in options.inputFiles]),
+                            inputCommands = cms.untracked.vstring(keepCommands(extraProducts)),
+                            dropDescendantsOfDroppedBranches = cms.untracked.bool(False))
+
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+
+# Same gen muon selection as process.muonAnalysis in MuonAnalyzer_cfg.py
+process.nEventsTotal   = cms.EDProducer("EventCountProducer")
+process.genMuonFilter  = cms.EDFilter("GenMuonFilter",
+                                      pruned = cms.InputTag("prunedGenParticles"),
+                                      maxEta = cms.double(2.4),
+                                      minPt = cms.double(10),  # first ptBins edge
+                                      minMuons = cms.uint32(1))
+process.nEventsSkimmed = cms.EDProducer("EventCountProducer")
+
+process.skim = cms.Path(process.nEventsTotal * process.genMuonFilter * process.nEventsSkimmed)
+
+process.out = cms.OutputModule("PoolOutputModule",
+                               fileName = cms.untracked.string(options.outputFile),
+                               SelectEvents = cms.untracked.PSet(SelectEvents = cms.vstring('skim')),
+                               outputCommands = cms.untracked.vstring(keepCommands(extraProducts) + ['keep edmMergeableCounter_*_*_*']))
+
+process.e = cms.EndPath(process.out)